@@ -0,0 +1,118 @@
+/**
+   \file
+
+   Минимальная обвязка для микробенчмарков в духе google benchmark.
+
+   Бенчмарк -- это функция принимающая State&. Она крутит цикл
+   пока State::keepRunning() возвращает true, а число итераций
+   подбирает main.cpp:
+   \code
+   static void direct_call(bench::State& state) {
+       int x = 1;
+       while(state.keepRunning()) {
+           bench::doNotOptimize(x);
+           bench::doNotOptimize(func(x));
+       }
+   }
+   BENCHMARK(direct_call);
+   \endcode
+
+   Бенчмарк можно сравнить с базовым: BENCHMARK_RELATIVE(piped,
+   direct_call) печатает отношение piped к direct_call, а
+   BENCHMARK_OVERHEAD ещё и проверяет это отношение, если main
+   запущен с --max-overhead=R. Для шаблонов по размеру аргумента
+   есть варианты с суффиксом _TEMPLATE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    /**
+       Состояние одного прогона бенчмарка
+    */
+    class State {
+        std::size_t m_iterations;
+        std::size_t m_left;
+    public:
+        explicit State(std::size_t iterations)
+            : m_iterations(iterations),
+              m_left(iterations) {}
+
+        bool keepRunning() {
+            return m_left-- != 0;
+        }
+
+        std::size_t iterations() const {
+            return m_iterations;
+        }
+    };
+
+    /**
+       Не даёт компилятору выбросить вычисление value
+    */
+    template <class T>
+    inline void doNotOptimize(T&& value) {
+        asm volatile("" : : "r,m"(value));
+    }
+
+    /**
+       Заставляет компилятор считать, что value
+       могло измениться
+    */
+    template <class T>
+    inline void clobber(T& value) {
+        asm volatile("" : "+r,m"(value));
+    }
+
+    struct Case {
+        std::string m_name;
+        void (*m_func)(State&);
+        /**
+           Имя базового бенчмарка или пустая строка
+        */
+        std::string m_baseline;
+        /**
+           Проверять ли отношение к базовому по --max-overhead
+        */
+        bool m_checked;
+    };
+
+    inline std::vector<Case>& registry() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, void (*func)(State&),
+                  const char* baseline = "", bool checked = false) {
+            registry().push_back(Case{name, func, baseline, checked});
+        }
+    };
+
+} /* namespace bench */
+
+#define BENCHMARK(FUNC)                                                 \
+    static ::bench::Registrar FUNC ## _registrar(#FUNC, FUNC)
+
+#define BENCHMARK_RELATIVE(FUNC, BASELINE)                              \
+    static ::bench::Registrar FUNC ## _registrar(#FUNC, FUNC, #BASELINE)
+
+#define BENCHMARK_OVERHEAD(FUNC, BASELINE)                              \
+    static ::bench::Registrar FUNC ## _registrar(#FUNC, FUNC, #BASELINE, true)
+
+#define BENCHMARK_TEMPLATE(FUNC, ARG)                                   \
+    static ::bench::Registrar FUNC ## _ ## ARG ## _registrar(           \
+        #FUNC "<" #ARG ">", FUNC<ARG>)
+
+#define BENCHMARK_TEMPLATE_RELATIVE(FUNC, BASELINE, ARG)                \
+    static ::bench::Registrar FUNC ## _ ## ARG ## _registrar(           \
+        #FUNC "<" #ARG ">", FUNC<ARG>, #BASELINE "<" #ARG ">")
+
+#define BENCHMARK_TEMPLATE_OVERHEAD(FUNC, BASELINE, ARG)                \
+    static ::bench::Registrar FUNC ## _ ## ARG ## _registrar(           \
+        #FUNC "<" #ARG ">", FUNC<ARG>, #BASELINE "<" #ARG ">", true)
@@ -0,0 +1,141 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/any.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace {
+
+    int f1(int n) {
+        return n + 1;
+    }
+
+    int f2(int n) {
+        return n * 3;
+    }
+
+    int f3(int n) {
+        return n - 2;
+    }
+
+    void any_static(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = pipe_op(f1) | pipe_op(f2) | pipe_op(f3);
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(any_static);
+
+    void any_pipe_op_chain(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = any_pipe_op<int(int)>(pipe_op(f1) | pipe_op(f2) | pipe_op(f3));
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(any_pipe_op_chain);
+
+    void any_std_function_chain(bench::State& state) {
+        using namespace pipeline;
+
+        const std::function<int(int)> chain = pipe_op(f1) | pipe_op(f2) | pipe_op(f3);
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(chain(x));
+        }
+    }
+    BENCHMARK(any_std_function_chain);
+
+    /**
+       Создание стадии на каждой итерации: цепочка из трёх
+       указателей не помещается в буфер std::function
+    */
+    void any_pipe_op_build(bench::State& state) {
+        using namespace pipeline;
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            const auto chain = any_pipe_op<int(int)>(pipe_op(f1) | pipe_op(f2) | pipe_op(f3));
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(any_pipe_op_build);
+
+    void any_std_function_build(bench::State& state) {
+        using namespace pipeline;
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            const std::function<int(int)> chain = pipe_op(f1) | pipe_op(f2) | pipe_op(f3);
+            bench::doNotOptimize(chain(x));
+        }
+    }
+    BENCHMARK(any_std_function_build);
+
+    /**
+       Стадии собранные во время выполнения: по одному
+       косвенному вызову на стадию
+    */
+    void any_pipe_op_stages(bench::State& state) {
+        using namespace pipeline;
+
+        std::vector<AnyPipeOp<int(int)>> stages;
+        stages.push_back(any_pipe_op<int(int)>(f1));
+        stages.push_back(any_pipe_op<int(int)>(f2));
+        stages.push_back(any_pipe_op<int(int)>(f3));
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            int value = x;
+            for(const auto& stage : stages)
+                value = value | stage;
+            bench::doNotOptimize(value);
+        }
+    }
+    BENCHMARK(any_pipe_op_stages);
+
+    void any_dynamic_pipeline_stages(bench::State& state) {
+        using namespace pipeline;
+
+        DynamicPipeline<int> stages;
+        stages.append(f1).append(f2).append(f3);
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | stages);
+        }
+    }
+    BENCHMARK(any_dynamic_pipeline_stages);
+
+    void any_std_function_stages(bench::State& state) {
+        std::vector<std::function<int(int)>> stages{f1, f2, f3};
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            int value = x;
+            for(const auto& stage : stages)
+                value = stage(value);
+            bench::doNotOptimize(value);
+        }
+    }
+    BENCHMARK(any_std_function_stages);
+
+} /* namespace */
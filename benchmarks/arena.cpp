@@ -0,0 +1,93 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/arena.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace {
+
+    const char line[] = "the quick brown fox jumps over the lazy dog "
+        "and keeps running through the long grass";
+
+    template <class String, class Vector>
+    Vector split(const char* text) {
+        Vector words;
+        String word;
+        for(; *text; ++text) {
+            if(*text != ' ') {
+                word.push_back(*text);
+            } else if(!word.empty()) {
+                words.push_back(word);
+                word.clear();
+            }
+        }
+        if(!word.empty())
+            words.push_back(word);
+        return words;
+    }
+
+    template <class Vector>
+    std::size_t long_words(const Vector& words) {
+        std::size_t count = 0;
+        for(const auto& word : words)
+            count += word.size() > 16;
+        return count;
+    }
+
+    /**
+       Слова длиннее буфера короткой строки, поэтому каждое
+       слово -- отдельное выделение памяти
+    */
+    template <class String>
+    String widen(const char* text) {
+        String result;
+        for(; *text; ++text) {
+            result.push_back(*text);
+            if(*text != ' ')
+                result.append(3, *text);
+        }
+        return result;
+    }
+
+    void arena_off(bench::State& state) {
+        using namespace pipeline;
+
+        using String = std::string;
+        using Vector = std::vector<String>;
+
+        const auto chain = pipe_op([](const char* text) { return widen<String>(text); })
+            | pipe_op([](const String& text) { return split<String, Vector>(text.c_str()); })
+            | pipe_op(long_words<Vector>);
+
+        const char* text = line;
+        while(state.keepRunning()) {
+            bench::clobber(text);
+            bench::doNotOptimize(text | chain);
+        }
+    }
+    BENCHMARK(arena_off);
+
+    void arena_on(bench::State& state) {
+        using namespace pipeline;
+
+        using String = ArenaString;
+        using Vector = ArenaVector<String>;
+
+        const auto chain = pipe_op([](const char* text) { return widen<String>(text); })
+            | pipe_op([](const String& text) { return split<String, Vector>(text.c_str()); })
+            | pipe_op(long_words<Vector>);
+
+        Arena arena;
+        const char* text = line;
+        while(state.keepRunning()) {
+            ArenaScope scope(arena);
+            bench::clobber(text);
+            bench::doNotOptimize(text | chain);
+        }
+    }
+    BENCHMARK_RELATIVE(arena_on, arena_off);
+
+} /* namespace */
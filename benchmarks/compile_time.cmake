@@ -0,0 +1,103 @@
+# Замер времени компиляции и памяти компилятора на файле с
+# COUNT местами вызова pipeline.
+#
+# Запускается целью compile_benchmark:
+#   cmake --build . --target compile_benchmark
+# или напрямую:
+#   cmake -DCOMPILER=g++ -DCOMPILER_ID=GNU -DINCLUDE_DIR=include/
+#         -DWORK_DIR=/tmp/compile -DCOUNTS=100,500 -P compile_time.cmake
+#
+# Каждое место вызова -- это своя лямбда, поэтому для него
+# инстанцируются свои Bind, Callable и UnpackTuple. Число
+# связанных аргументов меняется от 1 до 8.
+#
+# Память показывается только для GCC: это сколько всего выделил
+# его сборщик мусора(строка TOTAL в -ftime-report).
+
+cmake_minimum_required(VERSION 3.1)
+
+if(NOT COUNTS)
+  set(COUNTS 100,500)
+endif()
+string(REPLACE "," ";" COUNTS "${COUNTS}")
+
+separate_arguments(FLAGS_LIST UNIX_COMMAND "${FLAGS}")
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(generate_source FILE COUNT)
+  set(CODE "#include <pipeline/args.hpp>\n#include <pipeline/pipeline.hpp>\n\n")
+  math(EXPR LAST "${COUNT} - 1")
+  foreach(I RANGE ${LAST})
+    math(EXPR ARITY "${I} % 8 + 1")
+    set(PARAMS "int v")
+    set(SUM "v")
+    set(ARGS "")
+    foreach(J RANGE 1 ${ARITY})
+      set(PARAMS "${PARAMS}, int a${J}")
+      set(SUM "${SUM} + a${J}")
+      if(ARGS)
+        set(ARGS "${ARGS}, ${J}")
+      else()
+        set(ARGS "${J}")
+      endif()
+    endforeach()
+    set(CODE "${CODE}int site${I}(int x) {\n")
+    set(CODE "${CODE}    return x | [](${PARAMS}) { return ${SUM} + ${I}; } A(${ARGS})\n")
+    set(CODE "${CODE}        | pipeline::pipe_op([](int v) { return v * ${I}; });\n}\n\n")
+  endforeach()
+  file(WRITE ${FILE} "${CODE}")
+endfunction()
+
+function(now RESULT)
+  if(CMAKE_VERSION VERSION_LESS 3.23)
+    string(TIMESTAMP TIME "%s")
+    set(TIME "${TIME}.0")
+  else()
+    string(TIMESTAMP TIME "%s.%f")
+  endif()
+  set(${RESULT} ${TIME} PARENT_SCOPE)
+endfunction()
+
+message("call sites      seconds      memory")
+
+foreach(COUNT ${COUNTS})
+  set(SOURCE ${WORK_DIR}/sites${COUNT}.cpp)
+  generate_source(${SOURCE} ${COUNT})
+
+  now(START)
+  execute_process(
+    COMMAND ${COMPILER} ${FLAGS_LIST} -I${INCLUDE_DIR}
+            -c ${SOURCE} -o ${WORK_DIR}/sites${COUNT}.o
+    RESULT_VARIABLE RESULT
+    ERROR_VARIABLE ERRORS)
+  now(STOP)
+
+  if(NOT RESULT EQUAL 0)
+    message(FATAL_ERROR "compilation of ${SOURCE} failed:\n${ERRORS}")
+  endif()
+
+  # в CMake нет дробной арифметики, поэтому время
+  # считается в миллисекундах
+  string(REGEX REPLACE "^([0-9]+)\\.([0-9][0-9][0-9]).*" "\\1\\2" START_MS "${START}00")
+  string(REGEX REPLACE "^([0-9]+)\\.([0-9][0-9][0-9]).*" "\\1\\2" STOP_MS "${STOP}00")
+  math(EXPR ELAPSED "${STOP_MS} - ${START_MS}")
+  math(EXPR SECONDS "${ELAPSED} / 1000")
+  math(EXPR MILLISECONDS "${ELAPSED} % 1000 + 1000")
+  string(SUBSTRING ${MILLISECONDS} 1 3 MILLISECONDS)
+
+  # -ftime-report заметно замедляет компиляцию, поэтому
+  # память замеряется отдельным запуском
+  set(MEMORY "n/a")
+  if(COMPILER_ID STREQUAL "GNU")
+    execute_process(
+      COMMAND ${COMPILER} ${FLAGS_LIST} -ftime-report -I${INCLUDE_DIR}
+              -c ${SOURCE} -o ${WORK_DIR}/sites${COUNT}.o
+      ERROR_VARIABLE REPORT)
+  endif()
+  if(REPORT MATCHES "TOTAL[ :0-9.]+ ([0-9]+[kMG])")
+    set(MEMORY ${CMAKE_MATCH_1})
+  endif()
+
+  message("${COUNT}\t\t${SECONDS}.${MILLISECONDS}\t\t${MEMORY}")
+endforeach()
@@ -0,0 +1,72 @@
+
+#include "Benchmark.hpp"
+
+#include <pipeline/pipeline.hpp>
+
+namespace {
+
+    int f1(int n) {
+        return n + 1;
+    }
+
+    int f2(int n) {
+        return n * 3;
+    }
+
+    int f3(int n) {
+        return n - 2;
+    }
+
+    void compose_direct(bench::State& state) {
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(f3(f2(f1(x))));
+        }
+    }
+    BENCHMARK(compose_direct);
+
+    void compose_piped(bench::State& state) {
+        using namespace pipeline;
+
+        auto op1 = pipe_op(f1);
+        auto op2 = pipe_op(f2);
+        auto op3 = pipe_op(f3);
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | op1 | op2 | op3);
+        }
+    }
+    BENCHMARK(compose_piped);
+
+    void compose_prebuilt(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = pipe_op(f1) | pipe_op(f2) | pipe_op(f3);
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(compose_prebuilt);
+
+    void compose_prebuilt_static(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = pipe_op<decltype(&f1), &f1>()
+            | pipe_op<decltype(&f2), &f2>()
+            | pipe_op<decltype(&f3), &f3>();
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(compose_prebuilt_static);
+
+} /* namespace */
@@ -0,0 +1,222 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/args.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+   Стоимость вызова стадии через pipeline в сравнении с прямым
+   вызовом, лямбдой, std::bind и std::function. Аргумент
+   передаётся по значению, поэтому лишние копии в обёртках видны
+   тем сильнее, чем больше аргумент.
+
+   dispatch_* с базовым dispatch_direct_* должны совпадать с ним,
+   это проверяет --max-overhead.
+*/
+namespace {
+
+    template <std::size_t Size>
+    struct Payload {
+        std::array<std::uint64_t, Size / sizeof(std::uint64_t)> m_data;
+
+        Payload() {
+            m_data.fill(1);
+        }
+
+        std::uint64_t sum(std::uint64_t k) const {
+            return m_data.front() + m_data.back() + k;
+        }
+    };
+
+    template <std::size_t Size>
+    __attribute__((noinline))
+    std::uint64_t first(Payload<Size> payload) {
+        return payload.m_data.front();
+    }
+
+    template <std::size_t Size>
+    __attribute__((noinline))
+    std::uint64_t add(Payload<Size> payload, std::uint64_t k) {
+        return payload.m_data.front() + k;
+    }
+
+    /* Базовые вызовы ----------------------------------------------- */
+
+    template <std::size_t Size>
+    void dispatch_direct_first(bench::State& state) {
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::doNotOptimize(first(payload));
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_direct_add(bench::State& state) {
+        Payload<Size> payload;
+        std::uint64_t k = 2;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::clobber(k);
+            bench::doNotOptimize(add(payload, k));
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_direct_method(bench::State& state) {
+        Payload<Size> payload;
+        std::uint64_t k = 2;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::clobber(k);
+            bench::doNotOptimize(payload.sum(k));
+        }
+    }
+
+    /* pipeline ----------------------------------------------------- */
+
+    template <std::size_t Size>
+    void dispatch_pipe_op(bench::State& state) {
+        using namespace pipeline;
+
+        const auto op = pipe_op(first<Size>);
+
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::doNotOptimize(payload | op);
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_pipe_op_static(bench::State& state) {
+        using namespace pipeline;
+
+        const auto op = pipe_op<decltype(&first<Size>), &first<Size>>();
+
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::doNotOptimize(payload | op);
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_args(bench::State& state) {
+        Payload<Size> payload;
+        std::uint64_t k = 2;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::clobber(k);
+            bench::doNotOptimize(payload | add<Size> A(k));
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_factory(bench::State& state) {
+        using namespace pipeline;
+
+        const auto add_ = pipe_op_factory(add<Size>);
+
+        Payload<Size> payload;
+        std::uint64_t k = 2;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::clobber(k);
+            bench::doNotOptimize(payload | add_(k));
+        }
+    }
+
+    /**
+       Заранее созданный Bind: аргумент связан один раз,
+       а не на каждой итерации. Связанная константа не
+       затирается clobber, в отличии от k в базовом замере,
+       поэтому замер только для сравнения, без --max-overhead.
+    */
+    template <std::size_t Size>
+    void dispatch_bind(bench::State& state) {
+        using namespace pipeline;
+
+        auto bound = pipe_op_factory(add<Size>)(std::uint64_t(2));
+
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::doNotOptimize(payload | bound);
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_method(bench::State& state) {
+        Payload<Size> payload;
+        std::uint64_t k = 2;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::clobber(k);
+            bench::doNotOptimize(payload | &Payload<Size>::sum A(k));
+        }
+    }
+
+    /* Другие способы ----------------------------------------------- */
+
+    template <std::size_t Size>
+    void dispatch_lambda(bench::State& state) {
+        std::uint64_t k = 2;
+        const auto lambda = [&k](const Payload<Size>& payload) {
+            return add(payload, k);
+        };
+
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::clobber(k);
+            bench::doNotOptimize(lambda(payload));
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_std_bind(bench::State& state) {
+        const auto bound = std::bind(add<Size>, std::placeholders::_1, std::uint64_t(2));
+
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::doNotOptimize(bound(payload));
+        }
+    }
+
+    template <std::size_t Size>
+    void dispatch_std_function(bench::State& state) {
+        const std::function<std::uint64_t(Payload<Size>)> function =
+            std::bind(add<Size>, std::placeholders::_1, std::uint64_t(2));
+
+        Payload<Size> payload;
+        while(state.keepRunning()) {
+            bench::clobber(payload);
+            bench::doNotOptimize(function(payload));
+        }
+    }
+
+} /* namespace */
+
+#define DISPATCH_BENCHMARKS(SIZE)                                       \
+    BENCHMARK_TEMPLATE(dispatch_direct_first, SIZE);                    \
+    BENCHMARK_TEMPLATE_OVERHEAD(dispatch_pipe_op, dispatch_direct_first, SIZE); \
+    BENCHMARK_TEMPLATE_OVERHEAD(dispatch_pipe_op_static, dispatch_direct_first, SIZE); \
+    BENCHMARK_TEMPLATE(dispatch_direct_add, SIZE);                      \
+    BENCHMARK_TEMPLATE_OVERHEAD(dispatch_args, dispatch_direct_add, SIZE); \
+    BENCHMARK_TEMPLATE_OVERHEAD(dispatch_factory, dispatch_direct_add, SIZE); \
+    BENCHMARK_TEMPLATE_RELATIVE(dispatch_bind, dispatch_direct_add, SIZE); \
+    BENCHMARK_TEMPLATE_RELATIVE(dispatch_lambda, dispatch_direct_add, SIZE); \
+    BENCHMARK_TEMPLATE_RELATIVE(dispatch_std_bind, dispatch_direct_add, SIZE); \
+    BENCHMARK_TEMPLATE_RELATIVE(dispatch_std_function, dispatch_direct_add, SIZE); \
+    BENCHMARK_TEMPLATE(dispatch_direct_method, SIZE);                   \
+    BENCHMARK_TEMPLATE_OVERHEAD(dispatch_method, dispatch_direct_method, SIZE)
+
+DISPATCH_BENCHMARKS(8);
+DISPATCH_BENCHMARKS(64);
+DISPATCH_BENCHMARKS(512);
@@ -0,0 +1,82 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/expected.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+
+    int parse_or_throw(int n) {
+        if(n < 0)
+            throw std::invalid_argument("negative");
+        return n;
+    }
+
+    pipeline::Expected<int, std::error_code> parse(int n) {
+        if(n < 0)
+            return pipeline::make_unexpected(std::make_error_code(std::errc::invalid_argument));
+        return n;
+    }
+
+    int f1(int n) {
+        return n + 1;
+    }
+
+    int f2(int n) {
+        return n * 3;
+    }
+
+    /**
+       Плохой ввод: стадия бросает исключение, цепочка
+       прерывается раскруткой стека
+    */
+    void expected_error_throw(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = pipe_op(parse_or_throw) | pipe_op(f1) | pipe_op(f2);
+
+        int x = -1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            try {
+                bench::doNotOptimize(x | chain);
+            } catch(const std::invalid_argument&) {
+                bench::doNotOptimize(x);
+            }
+        }
+    }
+    BENCHMARK(expected_error_throw);
+
+    /**
+       Плохой ввод: ошибка проходит до конца цепочки
+       в Expected
+    */
+    void expected_error_channel(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = pipe_op(parse) | pipe_op(f1) | pipe_op(f2);
+
+        int x = -1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(expected_error_channel);
+
+    void expected_ok_channel(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = pipe_op(parse) | pipe_op(f1) | pipe_op(f2);
+
+        int x = 1;
+        while(state.keepRunning()) {
+            bench::clobber(x);
+            bench::doNotOptimize(x | chain);
+        }
+    }
+    BENCHMARK(expected_ok_channel);
+
+} /* namespace */
@@ -0,0 +1,76 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/parallel.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+   Сумма sqrt(x) по 1 000 000 чисел: par_map и затем свёртка в
+   вызывающем потоке против par_fold, где свёртка тоже
+   выполняется в пуле.
+*/
+namespace {
+
+    const std::vector<double>& values() {
+        static const std::vector<double> values = [] {
+            std::vector<double> values;
+            for(std::size_t i = 0; i < 1000000; ++i)
+                values.push_back(static_cast<double>(i % 1000));
+            return values;
+        }();
+        return values;
+    }
+
+    struct Root {
+        double operator()(double x) const {
+            return std::sqrt(x);
+        }
+    };
+
+    struct AddRoot {
+        double operator()(double acc, double x) const {
+            return acc + std::sqrt(x);
+        }
+    };
+
+    struct Add {
+        double operator()(double lhs, double rhs) const {
+            return lhs + rhs;
+        }
+    };
+
+    void fold_par_map_serial(bench::State& state) {
+        using namespace pipeline;
+
+        const auto roots = par_map(Root());
+        while(state.keepRunning()) {
+            double total = 0;
+            for(double root : values() | roots)
+                total += root;
+            bench::doNotOptimize(total);
+        }
+    }
+    BENCHMARK(fold_par_map_serial);
+
+    void fold_par_fold(bench::State& state) {
+        using namespace pipeline;
+
+        const auto total = par_fold(0.0, AddRoot(), Add());
+        while(state.keepRunning())
+            bench::doNotOptimize(values() | total);
+    }
+    BENCHMARK_RELATIVE(fold_par_fold, fold_par_map_serial);
+
+    void fold_par_fold_ordered(bench::State& state) {
+        using namespace pipeline;
+
+        const auto total = par_fold(0.0, AddRoot(), Add(), FoldOrder::ordered);
+        while(state.keepRunning())
+            bench::doNotOptimize(values() | total);
+    }
+    BENCHMARK_RELATIVE(fold_par_fold_ordered, fold_par_map_serial);
+
+} /* namespace */
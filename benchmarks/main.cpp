@@ -0,0 +1,118 @@
+
+#include "Benchmark.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace {
+
+    double run(const bench::Case& c, std::size_t iterations) {
+        bench::State state(iterations);
+
+        auto start = std::chrono::steady_clock::now();
+        c.m_func(state);
+        auto stop = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+    /**
+       Увеличивает число итераций пока прогон не станет
+       достаточно длинным для замера
+    */
+    double measure(const bench::Case& c) {
+        const double min_time_ns = 2e8;
+
+        std::size_t iterations = 1;
+        for(;;) {
+            double elapsed = run(c, iterations);
+            if(elapsed >= min_time_ns || iterations >= (std::size_t(1) << 40))
+                return elapsed / iterations;
+
+            double scale = elapsed > 0 ? min_time_ns * 1.2 / elapsed : 100;
+            if(scale > 100)
+                scale = 100;
+            if(scale < 2)
+                scale = 2;
+            iterations = static_cast<std::size_t>(iterations * scale);
+        }
+    }
+
+    /**
+       Замеры по именам: базовый бенчмарк замеряется один
+       раз, даже если с ним сравнивается несколько других
+    */
+    class Results {
+        std::map<std::string, double> m_results;
+    public:
+        double get(const bench::Case& c) {
+            auto found = m_results.find(c.m_name);
+            if(found != m_results.end())
+                return found->second;
+            return m_results[c.m_name] = measure(c);
+        }
+
+        double get(const std::string& name) {
+            for(const auto& c : bench::registry())
+                if(c.m_name == name)
+                    return get(c);
+
+            std::fprintf(stderr, "unknown baseline %s\n", name.c_str());
+            std::exit(2);
+        }
+    };
+
+    const char max_overhead_option[] = "--max-overhead=";
+
+} /* namespace */
+
+/**
+   benchmarks [filter] [--max-overhead=R]
+
+   filter -- подстрока имени бенчмарка. С --max-overhead
+   программа завершается с кодом 1, если бенчмарк
+   зарегистрированный через BENCHMARK_OVERHEAD медленнее
+   своего базового больше чем в R раз.
+*/
+int main(int argc, char* argv[]) {
+    const char* filter = "";
+    double max_overhead = 0;
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], max_overhead_option, sizeof(max_overhead_option) - 1) == 0)
+            max_overhead = std::atof(argv[i] + sizeof(max_overhead_option) - 1);
+        else
+            filter = argv[i];
+    }
+
+    Results results;
+    int failed = 0;
+
+    std::printf("%-48s %12s %12s\n", "benchmark", "ns/op", "x baseline");
+    for(const auto& c : bench::registry()) {
+        if(std::strstr(c.m_name.c_str(), filter) == nullptr)
+            continue;
+
+        const double ns = results.get(c);
+        if(c.m_baseline.empty()) {
+            std::printf("%-48s %12.3f\n", c.m_name.c_str(), ns);
+            continue;
+        }
+
+        const double ratio = ns / results.get(c.m_baseline);
+        const bool over = c.m_checked && max_overhead > 0 && ratio > max_overhead;
+        std::printf("%-48s %12.3f %12.2f%s\n", c.m_name.c_str(), ns, ratio, over ? "  FAILED" : "");
+        failed += over;
+    }
+
+    if(failed) {
+        std::printf("%d benchmark(s) above --max-overhead=%g\n", failed, max_overhead);
+        return 1;
+    }
+
+    return 0;
+}
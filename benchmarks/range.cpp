@@ -0,0 +1,83 @@
+
+#include "Benchmark.hpp"
+
+#include <pipeline/pipeline.hpp>
+#include <pipeline/range.hpp>
+
+#include <vector>
+
+namespace {
+
+    const std::vector<int>& input() {
+        static const std::vector<int> data = [] {
+            std::vector<int> result;
+            for(int i = 0; i < 4096; ++i)
+                result.push_back(i * 7 % 1000);
+            return result;
+        }();
+        return data;
+    }
+
+    struct Scale {
+        int operator()(int n) const {
+            return n * 3 + 1;
+        }
+    };
+
+    struct Small {
+        bool operator()(int n) const {
+            return n < 1500;
+        }
+    };
+
+    const Scale scale;
+    const Small small;
+
+    void range_hand_written(bench::State& state) {
+        const auto& src = input();
+        while(state.keepRunning()) {
+            std::vector<int> result;
+            for(int n : src) {
+                int m = scale(n);
+                if(!small(m))
+                    continue;
+                result.push_back(m);
+                if(result.size() == 1024)
+                    break;
+            }
+            bench::doNotOptimize(result.data());
+        }
+    }
+    BENCHMARK(range_hand_written);
+
+    void range_fused(bench::State& state) {
+        using namespace pipeline;
+
+        const auto& src = input();
+        while(state.keepRunning()) {
+            auto result = src | map(Scale()) | filter(Small()) | take(1024) | to_vector;
+            bench::doNotOptimize(result.data());
+        }
+    }
+    BENCHMARK(range_fused);
+
+    void range_materialized(bench::State& state) {
+        const auto& src = input();
+        while(state.keepRunning()) {
+            std::vector<int> mapped;
+            for(int n : src)
+                mapped.push_back(scale(n));
+
+            std::vector<int> filtered;
+            for(int n : mapped)
+                if(small(n))
+                    filtered.push_back(n);
+
+            std::vector<int> result(filtered.begin(),
+                                    filtered.begin() + (filtered.size() < 1024 ? filtered.size() : 1024));
+            bench::doNotOptimize(result.data());
+        }
+    }
+    BENCHMARK(range_materialized);
+
+} /* namespace */
@@ -0,0 +1,107 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/pipeline.hpp>
+#include <pipeline/range.hpp>
+#include <pipeline/simd.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/**
+   Поэлементная арифметика и фильтр над 64K float: стадии map и
+   filter с to_vector против simd_map и simd_filter
+*/
+namespace {
+
+    const std::vector<float>& samples() {
+        static const std::vector<float> samples = [] {
+            std::vector<float> samples;
+            for(std::size_t i = 0; i < (1 << 16); ++i)
+                samples.push_back(static_cast<float>(static_cast<int>(i * 37 % 201) - 100));
+            return samples;
+        }();
+        return samples;
+    }
+
+    const auto rollup = [](auto x) { return min(max(x * 1.5f + 2.f, 0.f), 100.f); };
+    const auto positive = [](auto x) { return x > 0.f; };
+
+    pipeline::SimdLevel level(pipeline::SimdLevel level) {
+        return level <= pipeline::best_simd_level() ? level : pipeline::SimdLevel::scalar;
+    }
+
+    void map_range(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = map([](float x) { return rollup(Pack<float, 1>(x))[0]; }) | to_vector;
+        while(state.keepRunning())
+            bench::doNotOptimize(samples() | chain);
+    }
+    BENCHMARK(map_range);
+
+    template <pipeline::SimdLevel Level>
+    void map_simd(bench::State& state) {
+        using namespace pipeline;
+
+        const auto stage = simd_map(rollup, level(Level));
+        while(state.keepRunning())
+            bench::doNotOptimize(samples() | stage);
+    }
+    void map_scalar(bench::State& state) {
+        map_simd<pipeline::SimdLevel::scalar>(state);
+    }
+    BENCHMARK_RELATIVE(map_scalar, map_range);
+
+    void map_sse2(bench::State& state) {
+        map_simd<pipeline::SimdLevel::sse2>(state);
+    }
+    BENCHMARK_RELATIVE(map_sse2, map_range);
+
+    void map_avx2(bench::State& state) {
+        map_simd<pipeline::SimdLevel::avx2>(state);
+    }
+    BENCHMARK_RELATIVE(map_avx2, map_range);
+
+    void map_avx512(bench::State& state) {
+        map_simd<pipeline::SimdLevel::avx512>(state);
+    }
+    BENCHMARK_RELATIVE(map_avx512, map_range);
+
+    void filter_range(bench::State& state) {
+        using namespace pipeline;
+
+        const auto chain = filter([](float x) { return x > 0.f; }) | to_vector;
+        while(state.keepRunning())
+            bench::doNotOptimize(samples() | chain);
+    }
+    BENCHMARK(filter_range);
+
+    template <pipeline::SimdLevel Level>
+    void filter_simd(bench::State& state) {
+        using namespace pipeline;
+
+        const auto stage = simd_filter(positive, level(Level));
+        while(state.keepRunning())
+            bench::doNotOptimize(samples() | stage);
+    }
+    void filter_scalar(bench::State& state) {
+        filter_simd<pipeline::SimdLevel::scalar>(state);
+    }
+    BENCHMARK_RELATIVE(filter_scalar, filter_range);
+
+    void filter_sse2(bench::State& state) {
+        filter_simd<pipeline::SimdLevel::sse2>(state);
+    }
+    BENCHMARK_RELATIVE(filter_sse2, filter_range);
+
+    void filter_avx2(bench::State& state) {
+        filter_simd<pipeline::SimdLevel::avx2>(state);
+    }
+    BENCHMARK_RELATIVE(filter_avx2, filter_range);
+
+    void filter_avx512(bench::State& state) {
+        filter_simd<pipeline::SimdLevel::avx512>(state);
+    }
+    BENCHMARK_RELATIVE(filter_avx512, filter_range);
+
+} /* namespace */
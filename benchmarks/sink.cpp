@@ -0,0 +1,59 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/io.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+   Запись 1000 строк около 60 байт. Пишется в /dev/null, поэтому
+   замеряется стоимость записи на стороне конвейера, а не диска.
+*/
+namespace {
+
+    const std::vector<std::string>& lines() {
+        static const std::vector<std::string> lines = [] {
+            std::vector<std::string> lines;
+            for(std::size_t i = 0; i < 1000; ++i)
+                lines.emplace_back(40 + i * 7 % 41, 'a' + i % 26);
+            return lines;
+        }();
+        return lines;
+    }
+
+    void sink_fwrite(bench::State& state) {
+        using namespace pipeline;
+
+        std::FILE* file = std::fopen("/dev/null", "wb");
+        const auto write = pipe_op([file](const std::string& line) {
+                std::fwrite(line.data(), 1, line.size(), file);
+                std::fputc('\n', file);
+            });
+
+        while(state.keepRunning()) {
+            for(const auto& line : lines())
+                line | write;
+        }
+        std::fclose(file);
+    }
+    BENCHMARK(sink_fwrite);
+
+    void sink_file_sink(bench::State& state) {
+        using namespace pipeline;
+
+        FileSinkOptions options;
+        options.m_separator = "\n";
+        auto sink = file_sink("/dev/null", options);
+
+        while(state.keepRunning()) {
+            for(const auto& line : lines())
+                line | *sink;
+        }
+        flush_sink(*sink);
+    }
+    BENCHMARK_RELATIVE(sink_file_sink, sink_fwrite);
+
+} /* namespace */
@@ -0,0 +1,74 @@
+#include "Benchmark.hpp"
+
+#include <pipeline/details/DelimiterScan.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/**
+   Поиск границ строк в 1 МБ текста со строками около 60 байт
+*/
+namespace {
+
+    namespace pd = pipeline::details;
+
+    const std::string& text() {
+        static const std::string text = [] {
+            std::string text;
+            for(std::size_t i = 0; text.size() < (1 << 20); ++i) {
+                text.append(40 + i * 7 % 41, 'a' + i % 26);
+                text.push_back('\n');
+            }
+            return text;
+        }();
+        return text;
+    }
+
+    void split_memchr(bench::State& state) {
+        const std::string& data = text();
+        while(state.keepRunning()) {
+            std::size_t total = 0;
+            const char* begin = data.data();
+            const char* const end = begin + data.size();
+            while(begin != end) {
+                const void* found = std::memchr(begin, '\n', end - begin);
+                const char* record_end = found ? static_cast<const char*>(found) : end;
+                total += record_end - begin;
+                begin = found ? record_end + 1 : end;
+            }
+            bench::doNotOptimize(total);
+        }
+    }
+    BENCHMARK(split_memchr);
+
+    template <pd::SimdLevel level>
+    void split_scan(bench::State& state) {
+        const std::string& data = text();
+        const pd::DelimiterKernel kernel = pd::delimiter_kernel(level <= pd::best_simd_level() ? level : pd::SimdLevel::scalar);
+        while(state.keepRunning()) {
+            std::size_t total = 0;
+            pd::scan_records(data.data(), data.size(), '\n', [&total](const char* begin, const char* end) {
+                    total += end - begin;
+                    return true;
+                }, kernel);
+            bench::doNotOptimize(total);
+        }
+    }
+
+    void split_scalar(bench::State& state) {
+        split_scan<pd::SimdLevel::scalar>(state);
+    }
+    BENCHMARK_RELATIVE(split_scalar, split_memchr);
+
+    void split_sse2(bench::State& state) {
+        split_scan<pd::SimdLevel::sse2>(state);
+    }
+    BENCHMARK_RELATIVE(split_sse2, split_memchr);
+
+    void split_avx2(bench::State& state) {
+        split_scan<pd::SimdLevel::avx2>(state);
+    }
+    BENCHMARK_RELATIVE(split_avx2, split_memchr);
+
+} /* namespace */
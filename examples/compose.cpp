@@ -0,0 +1,33 @@
+
+#include <pipeline/args.hpp>
+#include <pipeline/pipeline.hpp>
+
+#include <iostream>
+
+int inc(int n) {
+    return n + 1;
+}
+
+int mul(int n, int k) {
+    return n * k;
+}
+
+void print(int n) {
+    std::cout << n << std::endl;
+}
+
+int main() {
+    using namespace pipeline;
+
+    auto mul_ = pipe_op_factory(mul);
+
+    // цепочка собирается один раз и потом применяется к значениям
+    auto chain = pipe_op(inc) | mul_(3) | pipe_op(inc);
+
+    for(int i = 0; i < 3; ++i)
+        i | chain | print A();
+
+    print(chain(10));
+
+    return 0;
+}
@@ -8,25 +8,33 @@
 #include <iostream>
 
 using namespace pipeline;
-using namespace pipeline::details;
-
-template <class T, class Callable>
-auto operator|(boost::optional<T>&& t, PipeOp<Callable>& op)
-    JUST_RETURN(
-        t ? op(std::move(t.get())) : decltype(op(std::move(t.get())))()
-        );
-
-template <class T, class Callable>
-auto operator|(boost::optional<T>&& t, const PipeOp<Callable>& op)
-    JUST_RETURN(
-        t ? op(std::move(t.get())) : decltype(op(std::move(t.get())))()
-        );
-
-template <class T, class Callable>
-auto operator|(boost::optional<T>&& t, PipeOp<Callable>&& op)
-    JUST_RETURN(
-        t ? op(std::move(t.get())) : decltype(op(std::move(t.get())))()
-        );
+
+// std::optional, указатели и умные указатели поддерживаются
+// сразу, а для других типов достаточно специализировать
+// MaybeTraits
+namespace pipeline {
+
+    template <class T>
+    struct MaybeTraits<boost::optional<T>> {
+        static bool has(const boost::optional<T>& maybe) {
+            return static_cast<bool>(maybe);
+        }
+
+        template <class TMaybe>
+        static decltype(auto) get(TMaybe&& maybe) {
+            return *std::forward<TMaybe>(maybe);
+        }
+
+        template <class R>
+        using Rebind = boost::optional<std::decay_t<R>>;
+
+        template <class R, class TMaybe>
+        static R fail(TMaybe&&) {
+            return R();
+        }
+    };
+
+} /* namespace pipeline */
 
 boost::optional<int> ok(int i) {
     return i + 1;
@@ -49,5 +57,9 @@ int main() {
     boost::optional<int>(1) | ok_ | ok_ | print_;
     boost::optional<int>(1) | ok_ | fail_ | print_;
 
+    // в композиции пустое значение сразу выходит в конец цепочки
+    auto chain = ok_ | fail_ | ok_ | ok_;
+    assert(!(1 | chain));
+
     return 0;
 }
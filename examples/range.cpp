@@ -0,0 +1,33 @@
+
+#include <pipeline/pipeline.hpp>
+#include <pipeline/range.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Record {
+    std::string m_name;
+    int m_age;
+
+    const std::string& name() const {
+        return m_name;
+    }
+};
+
+int main() {
+    using namespace pipeline;
+
+    std::vector<Record> records = {{"ann", 31}, {"bob", 17}, {"eve", 45}, {"tom", 52}};
+
+    auto names = records
+        | filter([](const Record& r) { return r.m_age >= 18; })
+        | map(&Record::name)
+        | take(2)
+        | to_vector;
+
+    for(const auto& name : names)
+        std::cout << name << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <pipeline/details/AnyFunction.hpp>
+#include <pipeline/details/DynamicPipeline.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::AnyFunction;
+    using pipeline::details::AnyPipeOp;
+    using pipeline::details::DynamicPipeline;
+    using pipeline::details::any_pipe_op;
+
+} /* namespace pipeline */
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <pipeline/details/Arena.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::Arena;
+    using pipeline::details::ArenaAllocator;
+    using pipeline::details::ArenaScope;
+    using pipeline::details::ArenaString;
+    using pipeline::details::ArenaVector;
+    using pipeline::details::current_arena;
+
+} /* namespace pipeline */
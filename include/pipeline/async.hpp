@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pipeline/details/Async.hpp>
+#include <pipeline/details/EventLoop.hpp>
+#include <pipeline/details/Task.hpp>
+
+#ifdef __cpp_lib_coroutine
+
+namespace pipeline {
+
+    using pipeline::details::Task;
+    using pipeline::details::EventLoop;
+    using pipeline::details::async;
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_coroutine */
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <pipeline/details/Cache.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::CacheStats;
+    using pipeline::details::cache;
+    using pipeline::details::sharded_cache;
+    using pipeline::details::cache_stats;
+
+} /* namespace pipeline */
@@ -0,0 +1,266 @@
+/**
+   \file
+
+   AnyFunction -- функциональный объект со стёртым типом, замена
+   std::function для стадий собираемых во время выполнения:
+   \code
+   std::vector<AnyPipeOp<int(int)>> stages;
+   stages.push_back(any_pipe_op<int(int)>(pipe_op(f) | pipe_op(g)));
+   \endcode
+
+   Объект размером до Size байт хранится прямо внутри AnyFunction,
+   без аллокации. Только больший объект(или объект, перемещение
+   которого может бросить исключение) размещается в куче.
+
+   Вызов -- это один косвенный вызов через указатель на функцию,
+   которая хранится в самом AnyFunction, а не в таблице
+   виртуальных функций. Перемещение и удаление
+   объекта идут через второй указатель и на вызов не влияют.
+
+   Вызов от этого не быстрее чем у std::function: там тоже один
+   косвенный вызов. В benchmarks/any.cpp any_pipe_op_chain и
+   any_std_function_chain расходятся в пределах шума, и
+   AnyPipeOp бывает медленнее на 10-20%. Выигрыш AnyPipeOp в
+   создании: цепочка из трёх стадий помещается в буфер, а
+   std::function для неё выделяет память.
+
+   Пустой AnyFunction(созданный по умолчанию или после
+   перемещения) при вызове бросает std::bad_function_call, как
+   std::function. Проверка ничего не стоит: вместо nullptr в
+   пустом объекте лежит указатель на бросающую функцию.
+
+   AnyFunction только перемещается, поэтому может хранить объекты
+   которые нельзя копировать.
+*/
+
+#pragma once
+
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Размер встроенного буфера AnyFunction по умолчанию
+        */
+        constexpr std::size_t any_function_size = 4 * sizeof(void*);
+
+        /**
+           Операции над объектом хранящимся в буфере AnyFunction.
+
+           \tparam Func тип хранимого объекта
+           \tparam Inline true если объект лежит в буфере, false
+           если в буфере лежит указатель на объект в куче
+        */
+        template <class Func, bool Inline>
+        struct AnyStorage;
+
+        template <class Func>
+        struct AnyStorage<Func, true> {
+            static constexpr std::size_t size = sizeof(Func);
+
+            static Func& get(void* buffer) {
+                return *static_cast<Func*>(buffer);
+            }
+
+            template <class TFunc>
+            static void create(void* buffer, TFunc&& func) {
+                new (buffer) Func(std::forward<TFunc>(func));
+            }
+
+            static void move(void* from, void* to) {
+                new (to) Func(std::move(get(from)));
+                get(from).~Func();
+            }
+
+            static void destroy(void* buffer) {
+                get(buffer).~Func();
+            }
+        };
+
+        template <class Func>
+        struct AnyStorage<Func, false> {
+            static constexpr std::size_t size = sizeof(Func*);
+
+            static Func& get(void* buffer) {
+                return **static_cast<Func**>(buffer);
+            }
+
+            template <class TFunc>
+            static void create(void* buffer, TFunc&& func) {
+                *static_cast<Func**>(buffer) = new Func(std::forward<TFunc>(func));
+            }
+
+            static void move(void* from, void* to) {
+                *static_cast<Func**>(to) = *static_cast<Func**>(from);
+            }
+
+            static void destroy(void* buffer) {
+                delete *static_cast<Func**>(buffer);
+            }
+        };
+
+        template <class Sig, std::size_t Size = any_function_size>
+        class AnyFunction;
+
+        /**
+           \tparam Ret возвращаемый тип
+           \tparam Arg тип единственного аргумента
+           \tparam Size размер встроенного буфера в байтах
+        */
+        template <class Ret, class Arg, std::size_t Size>
+        class AnyFunction<Ret(Arg), Size> final {
+            static_assert(Size >= sizeof(void*),
+                          "AnyFunction buffer must fit at least a pointer");
+
+            using Buffer = std::aligned_storage_t<Size, alignof(std::max_align_t)>;
+
+            /**
+               Действия m_manage: переместить из from в to или
+               удалить объект в from
+            */
+            enum class Action {
+                move,
+                destroy
+            };
+
+            /**
+               Скаляры передаются в m_call по значению, чтобы не
+               класть их в память ради ссылки
+            */
+            using Param = std::conditional_t<std::is_scalar<Arg>::value, Arg, Arg&&>;
+
+            Ret (*m_call)(void*, Param);
+            void (*m_manage)(Action, void*, void*);
+            mutable Buffer m_buffer;
+
+            template <class Func>
+            using IsInline = std::integral_constant<bool,
+                                                    sizeof(Func) <= Size &&
+                                                    alignof(Func) <= alignof(Buffer) &&
+                                                    std::is_nothrow_move_constructible<Func>::value>;
+
+            template <class Func>
+            using Storage = AnyStorage<Func, IsInline<Func>::value>;
+
+            template <class Func>
+            static Ret call(void* buffer, Param arg) {
+                return Storage<Func>::get(buffer)(std::forward<Arg>(arg));
+            }
+
+            static Ret callEmpty(void*, Param) {
+#ifdef __cpp_exceptions
+                throw std::bad_function_call();
+#else
+                std::abort();
+#endif /* __cpp_exceptions */
+            }
+
+            template <class Func>
+            static void manage(Action action, void* from, void* to) {
+                if(action == Action::move)
+                    Storage<Func>::move(from, to);
+                else
+                    Storage<Func>::destroy(from);
+            }
+
+            void reset() {
+                if(m_manage)
+                    m_manage(Action::destroy, &m_buffer, nullptr);
+                m_call = &callEmpty;
+                m_manage = nullptr;
+            }
+
+            void moveFrom(AnyFunction& other) {
+                if(other.m_manage)
+                    other.m_manage(Action::move, &other.m_buffer, &m_buffer);
+                m_call = other.m_call;
+                m_manage = other.m_manage;
+                other.m_call = &callEmpty;
+                other.m_manage = nullptr;
+            }
+        public:
+            /**
+               true если объект типа Func поместится во
+               встроенный буфер
+            */
+            template <class Func>
+            static constexpr bool fitsInline() {
+                return IsInline<std::decay_t<Func>>::value;
+            }
+
+            AnyFunction()
+                : m_call(&callEmpty),
+                  m_manage(nullptr) {}
+
+            template <class Func,
+                      class = std::enable_if_t<!std::is_same<std::decay_t<Func>, AnyFunction>::value>>
+            AnyFunction(Func&& func)
+                : m_call(&call<std::decay_t<Func>>),
+                  m_manage(&manage<std::decay_t<Func>>) {
+                Storage<std::decay_t<Func>>::create(&m_buffer, std::forward<Func>(func));
+            }
+
+            AnyFunction(AnyFunction&& other) noexcept
+                : m_call(&callEmpty),
+                  m_manage(nullptr) {
+                moveFrom(other);
+            }
+
+            AnyFunction& operator=(AnyFunction&& other) noexcept {
+                if(this != &other) {
+                    reset();
+                    moveFrom(other);
+                }
+                return *this;
+            }
+
+            AnyFunction(const AnyFunction&) = delete;
+            AnyFunction& operator=(const AnyFunction&) = delete;
+
+            ~AnyFunction() {
+                reset();
+            }
+
+            explicit operator bool() const {
+                return m_manage != nullptr;
+            }
+
+            /**
+               Как и у std::function, вызов константного
+               AnyFunction вызывает не константный объект
+            */
+            Ret operator()(Arg arg) const {
+                return m_call(&m_buffer, std::forward<Arg>(arg));
+            }
+        };
+
+        /**
+           PipeOp со стёртым типом
+        */
+        template <class Sig, std::size_t Size = any_function_size>
+        using AnyPipeOp = PipeOp<AnyFunction<Sig, Size>>;
+
+        /**
+           Эта функция создаёт AnyPipeOp из PipeOp, функции,
+           функционального объекта или метода:
+           any_pipe_op<int(int)>(pipe_op(f) | pipe_op(g)).
+        */
+        template <class Sig, std::size_t Size = any_function_size, class Func>
+        auto any_pipe_op(Func&& func) {
+            return AnyPipeOp<Sig, Size>(AnyFunction<Sig, Size>(pd::function(std::forward<Func>(func))));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
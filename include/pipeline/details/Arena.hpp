@@ -0,0 +1,298 @@
+/**
+   \file
+
+   Arena -- монотонный распределитель памяти для промежуточных
+   значений одного прогона pipeline.
+
+   Стадии которые возвращают строки и векторы, живущие только
+   до следующего |, платят за malloc и free каждого из них, а
+   потоки, одновременно гоняющие pipeline, ещё и спорят за
+   общий malloc. Арена выдаёт память сдвигом указателя в своих
+   блоках и освобождает всё сразу:
+   \code
+   Arena arena;
+   for(const auto& line : lines) {
+       ArenaScope scope(arena);
+       // ArenaString и ArenaVector внутри стадий берут
+       // память из arena
+       total += line | pipe_op(split) | pipe_op(count_words);
+   }   // вся память прогона возвращается в arena
+   \endcode
+
+   ArenaScope делает арену текущей для потока(current_arena())
+   и при выходе откатывает её к состоянию на входе, поэтому
+   вложенные области, например на один batch, тоже работают.
+   Значения выделенные в арене нельзя выносить за пределы
+   области -- их нужно скопировать в обычные контейнеры.
+
+   Арена не потокобезопасна: у каждого потока должна быть своя.
+   Потоки пула par_map не видят текущую арену вызывающего потока.
+
+   Блоки арены могут лежать на больших страницах(huge pages),
+   если это поддерживает система.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif /* __linux__ */
+
+namespace pipeline {
+
+    namespace details {
+
+        class Arena final {
+        public:
+            /**
+               Положение арены для отката: номер блока и
+               смещение в нём
+            */
+            struct Mark {
+                std::size_t m_block;
+                std::size_t m_offset;
+            };
+
+            static constexpr std::size_t default_block_size = 64 * 1024;
+            static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+        private:
+            struct Block {
+                char* m_data;
+                std::size_t m_size;
+                bool m_mapped;
+            };
+
+            std::vector<Block> m_blocks;
+            std::size_t m_block;
+            std::size_t m_offset;
+            const std::size_t m_block_size;
+            const bool m_huge_pages;
+
+            Block allocateBlock(std::size_t size) {
+#ifdef __linux__
+                if(m_huge_pages) {
+                    size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+                    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                    if(data == MAP_FAILED) {
+                        // нет заранее выделенных huge pages, тогда
+                        // просим transparent huge pages
+                        data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                        if(data == MAP_FAILED) {
+#ifdef __cpp_exceptions
+                            throw std::bad_alloc();
+#else
+                            std::abort();
+#endif /* __cpp_exceptions */
+                        }
+                        madvise(data, size, MADV_HUGEPAGE);
+                    }
+                    return Block{static_cast<char*>(data), size, true};
+                }
+#endif /* __linux__ */
+                return Block{static_cast<char*>(::operator new(size)), size, false};
+            }
+
+            static void freeBlock(const Block& block) {
+#ifdef __linux__
+                if(block.m_mapped) {
+                    munmap(block.m_data, block.m_size);
+                    return;
+                }
+#endif /* __linux__ */
+                ::operator delete(block.m_data);
+            }
+
+            static std::size_t alignUp(const char* data, std::size_t offset, std::size_t align) {
+                const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(data) + offset;
+                return offset + (align - address % align) % align;
+            }
+        public:
+            /**
+               \param block_size размер блока, который арена
+               запрашивает у системы
+               \param huge_pages размещать блоки на больших
+               страницах, тогда размер блока округляется до 2 МБ.
+               Только для Linux, на других системах игнорируется
+            */
+            explicit Arena(std::size_t block_size = default_block_size, bool huge_pages = false)
+                : m_block(0),
+                  m_offset(0),
+                  m_block_size(block_size),
+                  m_huge_pages(huge_pages) {}
+
+            Arena(const Arena&) = delete;
+            Arena& operator=(const Arena&) = delete;
+
+            ~Arena() {
+                for(const Block& block : m_blocks)
+                    freeBlock(block);
+            }
+
+            void* allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+                for(; m_block < m_blocks.size(); ++m_block, m_offset = 0) {
+                    const Block& block = m_blocks[m_block];
+                    const std::size_t begin = alignUp(block.m_data, m_offset, align);
+                    if(begin + size <= block.m_size) {
+                        m_offset = begin + size;
+                        return block.m_data + begin;
+                    }
+                }
+
+                // ни один блок не подошёл: новый блок встаёт в
+                // конец и становится текущим
+                const std::size_t block_size = size + align > m_block_size ? size + align : m_block_size;
+                m_blocks.push_back(allocateBlock(block_size));
+                m_block = m_blocks.size() - 1;
+                const Block& block = m_blocks.back();
+                const std::size_t begin = alignUp(block.m_data, 0, align);
+                m_offset = begin + size;
+                return block.m_data + begin;
+            }
+
+            Mark mark() const {
+                return Mark{m_block, m_offset};
+            }
+
+            /**
+               Возвращает в арену всё выделенное после mark.
+               Блоки остаются у арены для следующих выделений.
+            */
+            void rewind(const Mark& mark) {
+                m_block = mark.m_block;
+                m_offset = mark.m_offset;
+            }
+
+            void reset() {
+                rewind(Mark{0, 0});
+            }
+
+            /**
+               Сколько байт выделено с последнего reset,
+               включая потери на выравнивание и концы блоков
+            */
+            std::size_t bytes() const {
+                std::size_t bytes = m_offset;
+                for(std::size_t i = 0; i < m_block && i < m_blocks.size(); ++i)
+                    bytes += m_blocks[i].m_size;
+                return bytes;
+            }
+
+            /**
+               Сколько байт арена взяла у системы
+            */
+            std::size_t capacity() const {
+                std::size_t capacity = 0;
+                for(const Block& block : m_blocks)
+                    capacity += block.m_size;
+                return capacity;
+            }
+        };
+
+        inline Arena*& current_arena_ref() {
+            static thread_local Arena* arena = nullptr;
+            return arena;
+        }
+
+        /**
+           Арена текущего прогона в этом потоке или nullptr
+        */
+        inline Arena* current_arena() {
+            return current_arena_ref();
+        }
+
+        /**
+           Делает arena текущей в этом потоке до конца области
+           и откатывает её при выходе
+        */
+        class ArenaScope final {
+            Arena& m_arena;
+            const Arena::Mark m_mark;
+            Arena* const m_previous;
+        public:
+            explicit ArenaScope(Arena& arena)
+                : m_arena(arena),
+                  m_mark(arena.mark()),
+                  m_previous(current_arena_ref()) {
+                current_arena_ref() = &arena;
+            }
+
+            ArenaScope(const ArenaScope&) = delete;
+            ArenaScope& operator=(const ArenaScope&) = delete;
+
+            ~ArenaScope() {
+                current_arena_ref() = m_previous;
+                m_arena.rewind(m_mark);
+            }
+        };
+
+        /**
+           Аллокатор для стандартных контейнеров. Созданный без
+           аргументов, он берёт текущую арену потока, а если её
+           нет -- работает через operator new.
+
+           deallocate для арены ничего не делает: память
+           вернётся при выходе из ArenaScope.
+        */
+        template <class T>
+        class ArenaAllocator {
+            template <class U>
+            friend class ArenaAllocator;
+
+            Arena* m_arena;
+        public:
+            using value_type = T;
+
+            ArenaAllocator() noexcept
+                : m_arena(current_arena()) {}
+
+            explicit ArenaAllocator(Arena* arena) noexcept
+                : m_arena(arena) {}
+
+            template <class U>
+            ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+                : m_arena(other.m_arena) {}
+
+            T* allocate(std::size_t n) {
+                if(m_arena)
+                    return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+                return static_cast<T*>(::operator new(n * sizeof(T)));
+            }
+
+            void deallocate(T* pointer, std::size_t) noexcept {
+                if(!m_arena)
+                    ::operator delete(pointer);
+            }
+
+            Arena* arena() const {
+                return m_arena;
+            }
+
+            template <class U>
+            bool operator==(const ArenaAllocator<U>& other) const {
+                return m_arena == other.m_arena;
+            }
+
+            template <class U>
+            bool operator!=(const ArenaAllocator<U>& other) const {
+                return m_arena != other.m_arena;
+            }
+        };
+
+        using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+        template <class T>
+        using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    } /* namespace details */
+
+} /* namespace pipeline */
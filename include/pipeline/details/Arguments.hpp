@@ -50,6 +50,7 @@ namespace pipeline {
         template <class Func, class... Args>
         auto operator<<(Func&& func, Arguments<Args...>&& args) {
             auto factory = pipe_op_factory(std::forward<Func>(func));
+            // фабрика временная, поэтому функция перемещается в PipeOp
             return UnpackTuple::call(std::move(factory),
                                      std::move(args.m_args));
         }
@@ -0,0 +1,152 @@
+/**
+   \file
+
+   Стадия async(op, executor) выполняет op как сопрограмму:
+   x | async(op, loop) возвращает Task с результатом op(x), а не
+   сам результат. Поток при этом не блокируется.
+
+   op -- любая функция или PipeOp. Если op вернул awaitable(Task,
+   loop.offload(...) и т.п.) или сам является сопрограммой, то
+   его результат ждётся через co_await. Если вход стадии тоже
+   awaitable, то сначала ждётся он, поэтому стадии async
+   соединяются в цепочку:
+   \code
+   EventLoop loop;
+   auto read = [&loop](std::string path) { return loop.offload([path] { return read_file(path); }); };
+   Task<std::size_t> lines = path | async(read, loop) | async(count_lines, loop);
+   std::size_t count = loop.run(std::move(lines));
+   \endcode
+
+   Вызов op и продолжение после co_await всегда выполняются в
+   потоке executor: стадия переходит в него через
+   co_await executor.schedule(). Подойдёт любой исполнитель с
+   таким методом, например EventLoop.
+
+   Task ленивый, поэтому вход копируется(или перемещается) в
+   сопрограмму, а executor должен жить пока она не завершится.
+   Maybe значения(std::optional, Expected и т.п.) обрабатываются
+   так же как у обычных стадий.
+
+   Только для C++20.
+*/
+
+#pragma once
+
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Maybe.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Task.hpp>
+
+#include <type_traits>
+#include <utility>
+
+#ifdef __cpp_lib_coroutine
+
+namespace pipeline {
+
+    namespace details {
+
+        template <class T, bool = IsAwaitable<T>::value>
+        struct AwaitedValue {
+            using type = T;
+        };
+
+        template <class T>
+        struct AwaitedValue<T, true> {
+            using type = std::decay_t<AwaitResult<T>>;
+        };
+
+        /**
+           Значение T после co_await, если T -- awaitable,
+           иначе сам T
+        */
+        template <class T>
+        using AwaitedValueT = typename AwaitedValue<T>::type;
+
+        template <class Func, class Arg>
+        using AsyncCallResult = decltype(pd::pipe_call(std::declval<Func&>(), std::declval<AwaitedValueT<Arg>>()));
+
+        template <class Func, class Arg, class = void>
+        struct AcceptsAsync : std::false_type {};
+
+        template <class Func, class Arg>
+        struct AcceptsAsync<Func, Arg, VoidT<AsyncCallResult<Func, Arg>>> : std::true_type {};
+
+        /**
+           Функциональный объект стадии async
+        */
+        template <class Func, class Executor>
+        class AsyncStage final {
+            Func m_func;
+            Executor* m_executor;
+
+            template <class Arg>
+            using Result = AwaitedValueT<std::decay_t<AsyncCallResult<Func, Arg>>>;
+
+            // временные объекты не участвуют в выражениях с co_await,
+            // а хранятся в именованных переменных(см. Task.hpp)
+
+            template <class Arg>
+            static Task<Result<Arg>> run(Func func, Executor* executor, Arg arg) {
+                co_await executor->schedule();
+
+                if constexpr(IsAwaitable<Arg>::value) {
+                    auto value = co_await std::move(arg);
+                    co_return co_await call(func, executor, value);
+                } else {
+                    co_return co_await call(func, executor, arg);
+                }
+            }
+
+            /**
+               Вызывает func и ждёт результат, если это awaitable
+            */
+            template <class Value>
+            static Task<Result<Value>> call(Func& func, Executor* executor, Value& value) {
+                using CallResult = AsyncCallResult<Func, Value>;
+
+                if constexpr(IsAwaitable<std::decay_t<CallResult>>::value) {
+                    auto awaitable = pd::pipe_call(func, std::move(value));
+                    if constexpr(std::is_void<Result<Value>>::value) {
+                        co_await std::move(awaitable);
+                        co_await executor->schedule();
+                    } else {
+                        auto result = co_await std::move(awaitable);
+                        co_await executor->schedule();
+                        co_return result;
+                    }
+                } else if constexpr(std::is_void<CallResult>::value) {
+                    pd::pipe_call(func, std::move(value));
+                } else {
+                    co_return pd::pipe_call(func, std::move(value));
+                }
+            }
+        public:
+            AsyncStage(Func func, Executor& executor)
+                : m_func(std::move(func)),
+                  m_executor(&executor) {}
+
+            template <class Arg,
+                      class = std::enable_if_t<AcceptsAsync<Func, std::decay_t<Arg>>::value>>
+            auto operator()(Arg&& arg) const {
+                return run<std::decay_t<Arg>>(m_func, m_executor, std::forward<Arg>(arg));
+            }
+        };
+
+        /**
+           Стадия выполняющая func как сопрограмму
+           в потоке executor
+        */
+        template <class Func, class Executor>
+        auto async(Func&& func, Executor& executor) {
+            auto callable = pd::function(std::forward<Func>(func));
+            return PipeOp<AsyncStage<decltype(callable), Executor>>(
+                AsyncStage<decltype(callable), Executor>(std::move(callable), executor));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_coroutine */
@@ -0,0 +1,250 @@
+/**
+   \file
+
+   Стадии для пакетной обработки: batch, map_batch и unbatch.
+
+   batch(n) собирает элементы в пакеты по n штук(последний пакет
+   может быть меньше) и передаёт дальше Span на буфер. Буфер один
+   на всё представление и переиспользуется для каждого пакета,
+   поэтому Span действителен только до следующего пакета, а
+   batch(n) | to_vector не компилируется.
+
+   map_batch(f) вызывает f для всего пакета если у f есть перегрузка
+   принимающая Span. Иначе f вызывается для каждого элемента, а
+   результаты складываются в переиспользуемый буфер и передаются
+   дальше тоже как Span.
+
+   unbatch разворачивает пакеты(или любые другие диапазоны) обратно
+   в отдельные элементы.
+
+   \code
+   struct Hash {
+       std::uint64_t operator()(const Record& r) const;
+       std::vector<std::uint64_t> operator()(Span<const Record> batch) const;
+   };
+
+   auto hashes = records | batch(256) | map_batch(Hash()) | unbatch | to_vector;
+   \endcode
+
+   Проверка наличия пакетной перегрузки делается через SFINAE,
+   поэтому обобщённые функциональные объекты должны выводить тип
+   возвращаемого значения через decltype(например с JUST_RETURN).
+*/
+
+#pragma once
+
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Range.hpp>
+#include <pipeline/details/Span.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Проверяет можно ли вызвать Func с аргументом типа Batch
+        */
+        template <class Func, class Batch, class = void>
+        struct AcceptsBatch : std::false_type {};
+
+        template <class Func, class Batch>
+        struct AcceptsBatch<Func, Batch,
+                            decltype(void(std::declval<Func&>()(std::declval<Batch>())))> : std::true_type {};
+
+        /**
+           Представление группирующее элементы Src в пакеты
+        */
+        template <class Src>
+        class BatchView final : public RangeView {
+            using Value = std::decay_t<typename Src::reference>;
+
+            Src m_src;
+            std::size_t m_size;
+            std::vector<Value> m_buffer;
+        public:
+            using reference = Span<Value>;
+
+            BatchView(Src src, std::size_t size)
+                : m_src(std::move(src)),
+                  m_size(size > 0 ? size : 1) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                m_buffer.clear();
+                m_buffer.reserve(m_size);
+
+                bool more = m_src.forEach([this, &sink](auto&& value) {
+                        m_buffer.push_back(std::forward<decltype(value)>(value));
+                        if(m_buffer.size() < m_size)
+                            return true;
+
+                        bool result = sink(reference(m_buffer.data(), m_buffer.size()));
+                        m_buffer.clear();
+                        return result;
+                    });
+
+                if(more && !m_buffer.empty())
+                    more = sink(reference(m_buffer.data(), m_buffer.size()));
+                m_buffer.clear();
+                return more;
+            }
+        };
+
+        template <class Src, class Func,
+                  bool = AcceptsBatch<Func, typename Src::reference>::value>
+        class BatchMapView;
+
+        /**
+           map_batch для функции с пакетной перегрузкой
+        */
+        template <class Src, class Func>
+        class BatchMapView<Src, Func, true> final : public RangeView {
+            Src m_src;
+            Func m_func;
+        public:
+            using reference = decltype(std::declval<Func&>()(std::declval<typename Src::reference>()));
+
+            BatchMapView(Src src, Func func)
+                : m_src(std::move(src)),
+                  m_func(std::move(func)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return m_src.forEach([this, &sink](auto&& batch) {
+                        return sink(m_func(std::forward<decltype(batch)>(batch)));
+                    });
+            }
+        };
+
+        /**
+           map_batch для функции без пакетной перегрузки:
+           функция вызывается для каждого элемента пакета
+        */
+        template <class Src, class Func>
+        class BatchMapView<Src, Func, false> final : public RangeView {
+            using Element = decltype(*std::begin(std::declval<typename Src::reference&>()));
+            using Value = std::decay_t<decltype(std::declval<Func&>()(std::declval<Element>()))>;
+
+            Src m_src;
+            Func m_func;
+            std::vector<Value> m_buffer;
+        public:
+            using reference = Span<Value>;
+
+            BatchMapView(Src src, Func func)
+                : m_src(std::move(src)),
+                  m_func(std::move(func)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return m_src.forEach([this, &sink](auto&& batch) {
+                        m_buffer.clear();
+                        for(auto&& value : batch)
+                            m_buffer.push_back(m_func(value));
+                        return sink(reference(m_buffer.data(), m_buffer.size()));
+                    });
+            }
+        };
+
+        /**
+           Представление разворачивающее пакеты Src в элементы
+        */
+        template <class Src>
+        class UnbatchView final : public RangeView {
+            Src m_src;
+        public:
+            using reference = decltype(*std::begin(std::declval<typename Src::reference&>()));
+
+            explicit UnbatchView(Src src)
+                : m_src(std::move(src)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return m_src.forEach([&sink](auto&& batch) {
+                        for(auto&& value : batch)
+                            if(!sink(value))
+                                return false;
+                        return true;
+                    });
+            }
+        };
+
+        /**
+           Функциональный объект стадии batch
+        */
+        class BatchStage final {
+            std::size_t m_size;
+        public:
+            explicit BatchStage(std::size_t size)
+                : m_size(size) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const {
+                return BatchView<AllView<Range>>(pd::all(std::forward<Range>(range)), m_size);
+            }
+        };
+
+        /**
+           Функциональный объект стадии map_batch
+        */
+        template <class Func>
+        class BatchMapStage final {
+            Func m_func;
+        public:
+            explicit BatchMapStage(Func func)
+                : m_func(std::move(func)) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const & {
+                return BatchMapView<AllView<Range>, Func>(pd::all(std::forward<Range>(range)), m_func);
+            }
+
+            template <class Range>
+            auto operator()(Range&& range) && {
+                return BatchMapView<AllView<Range>, Func>(pd::all(std::forward<Range>(range)), std::move(m_func));
+            }
+        };
+
+        /**
+           Функциональный объект стадии unbatch
+        */
+        struct UnbatchStage final {
+            template <class Range>
+            auto operator()(Range&& range) const {
+                return UnbatchView<AllView<Range>>(pd::all(std::forward<Range>(range)));
+            }
+        };
+
+        /**
+           Стадия собирающая элементы в пакеты по size штук
+        */
+        inline auto batch(std::size_t size) {
+            return PipeOp<BatchStage>(BatchStage(size));
+        }
+
+        /**
+           Стадия применяющая func к пакету целиком, или к
+           каждому элементу если пакетной перегрузки нет
+        */
+        template <class Func>
+        auto map_batch(Func&& func) {
+            auto callable = pd::function(std::forward<Func>(func));
+            return PipeOp<BatchMapStage<decltype(callable)>>(BatchMapStage<decltype(callable)>(std::move(callable)));
+        }
+
+        /**
+           Стадия разворачивающая пакеты: vec | batch(64) | unbatch
+        */
+        constexpr PipeOp<UnbatchStage> unbatch{UnbatchStage()};
+
+    } /* namespace details */
+
+} /* namespace pipeline */
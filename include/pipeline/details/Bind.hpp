@@ -8,7 +8,8 @@
 
    Bind не аллоцирует сам память и старается использовать семантику
    перемещения. Аллокация может произойти при копировании аргументов
-   и объектов для вызова.
+   и объектов для вызова. Пустой функциональный объект не занимает
+   места в Bind.
 
    Не имеет смысла создавать Bind напрямую. Для создания нужно
    использовать функцию bind.
@@ -16,6 +17,7 @@
 
 #pragma once
 
+#include <pipeline/details/Ebo.hpp>
 #include <pipeline/details/GenSeq.hpp>
 #include <pipeline/details/JustReturn.hpp>
 #include <pipeline/details/UnpackTuple.hpp>
@@ -38,15 +40,40 @@ namespace pipeline {
         */
         template <class Func,
                   class... Args>
-        class Bind final {
-            Func m_func;
+        class Bind final : private Ebo<Func, Bind<Func, Args...>> {
+            using Storage = Ebo<Func, Bind<Func, Args...>>;
+
             std::tuple<Args...> m_args;
+
+            /**
+               Вызов временного Bind с перемещением функции и
+               привязанных аргументов
+            */
+            template <class Self, class Arg>
+            static auto call(Self&& self, Arg&& arg, int)
+                JUST_RETURN(
+                    UnpackTuple::call(std::move(self).Storage::get(),
+                                      std::move(self.m_args),
+                                      std::forward<Arg>(arg))
+                    );
+
+            /**
+               Если функция не принимает аргументы как rvalue(например
+               параметр T&), то они передаются как lvalue
+            */
+            template <class Self, class Arg>
+            static auto call(Self&& self, Arg&& arg, long)
+                JUST_RETURN(
+                    UnpackTuple::call(self.Storage::get(),
+                                      self.m_args,
+                                      std::forward<Arg>(arg))
+                    );
         public:
             template <class TFunc,
                       class... TArgs>
             explicit Bind(TFunc&& func,
                           TArgs&&... args)
-                : m_func(std::forward<TFunc>(func)),
+                : Storage(std::forward<TFunc>(func)),
                   m_args(std::forward<TArgs>(args)...) {}
 
             /**
@@ -54,12 +81,35 @@ namespace pipeline {
                единственного непривязанного аргумента
             */
             template <class Arg>
-            auto operator()(Arg&& arg)
+            auto operator()(Arg&& arg) &
                 JUST_RETURN(
-                    UnpackTuple::call(m_func,
+                    UnpackTuple::call(this->get(),
                                       m_args,
                                       std::forward<Arg>(arg))
                     );
+
+            /**
+               Вызов константного Bind: функция и привязанные
+               аргументы передаются как const lvalue
+            */
+            template <class Arg>
+            auto operator()(Arg&& arg) const &
+                JUST_RETURN(
+                    UnpackTuple::call(this->get(),
+                                      m_args,
+                                      std::forward<Arg>(arg))
+                    );
+
+            /**
+               Вызов временного Bind: функция и привязанные
+               аргументы перемещаются в вызов. Так одноразовый
+               pipeline не копирует то, что в него передали.
+            */
+            template <class Arg>
+            auto operator()(Arg&& arg) &&
+                JUST_RETURN(
+                    call(std::move(*this), std::forward<Arg>(arg), 0)
+                    );
         };
 
         /**
@@ -68,7 +118,7 @@ namespace pipeline {
         template <class Func,
                   class... Args>
         auto bind(Func&& func, Args&&... args) {
-            return Bind<std::remove_reference_t<Func>,
+            return Bind<std::decay_t<Func>,
                         std::remove_reference_t<Args>...>
                 (std::forward<Func>(func),
                  std::forward<Args>(args)...);
@@ -0,0 +1,383 @@
+/**
+   \file
+
+   Стадия cache запоминает результаты чистой функции, чтобы не
+   считать их повторно для одинаковых входов:
+   \code
+   auto compile = cache<std::string>(compile_regex, 1024);
+   auto matches = line | compile | pipe_op(match);
+
+   CacheStats stats = cache_stats(compile);
+   \endcode
+
+   Результаты хранятся в таблице с открытой адресацией и
+   линейным пробированием. Таблица ограничена capacity записями,
+   при переполнении запись вытесняется по алгоритму CLOCK: у
+   каждой записи есть бит обращения, стрелка идёт по записям,
+   снимает биты и вытесняет первую запись без бита. Это даёт
+   почти LRU без списка и без записи в общую память при попадании
+   кроме одного бита.
+
+   sharded_cache -- вариант для параллельных стадий(par_map,
+   pipelined): таблица разбита на части со своими мьютексами,
+   часть выбирается по хешу ключа. Функция вызывается без
+   блокировки, поэтому должна быть потокобезопасной.
+
+   Копии стадии разделяют одну таблицу.
+*/
+
+#pragma once
+
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/CacheLine.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Перемешивает биты хеша. Младшие биты std::hash для
+           целых -- это само число, а подряд идущие ключи не
+           должны попадать в соседние слоты и в одну часть
+           sharded_cache.
+        */
+        inline std::uint64_t cache_mix(std::size_t hash) {
+            return static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+        }
+
+        struct CacheStats {
+            std::uint64_t m_hits;
+            std::uint64_t m_misses;
+            std::uint64_t m_evictions;
+            /**
+               Сколько записей сейчас в кэше
+            */
+            std::size_t m_size;
+        };
+
+        /**
+           Ограниченная таблица Key -> Value с вытеснением CLOCK.
+
+           Записи лежат в m_entries в порядке добавления, а
+           m_slots -- это открытая адресация по хешу с номерами
+           записей(0 -- пустой слот). Слотов хотя бы вдвое больше
+           чем записей, поэтому цепочки пробирования короткие.
+           Удаление сдвигает следующие слоты назад, так что
+           надгробия не нужны.
+        */
+        template <class Key, class Value, class Hash, class KeyEqual>
+        class CacheTable final {
+            struct Entry {
+                std::size_t m_hash;
+                Key m_key;
+                Value m_value;
+                bool m_referenced;
+
+                template <class TValue>
+                Entry(std::size_t hash, const Key& key, TValue&& value)
+                    : m_hash(hash),
+                      m_key(key),
+                      m_value(std::forward<TValue>(value)),
+                      m_referenced(false) {}
+            };
+
+            Hash m_hasher;
+            KeyEqual m_equal;
+            const std::size_t m_capacity;
+            std::vector<Entry> m_entries;
+            std::vector<std::uint32_t> m_slots;
+            std::size_t m_mask;
+            std::size_t m_hand;
+            CacheStats m_stats;
+
+            static std::size_t slotCount(std::size_t capacity) {
+                std::size_t count = 2;
+                while(count < 2 * capacity)
+                    count *= 2;
+                return count;
+            }
+
+            std::size_t home(std::size_t hash) const {
+                return (cache_mix(hash) >> 32) & m_mask;
+            }
+
+            /**
+               Слот записи с ключом key или пустой слот
+               куда её можно положить
+            */
+            std::size_t probe(const Key& key, std::size_t hash) const {
+                std::size_t slot = home(hash);
+                while(m_slots[slot] != 0) {
+                    const Entry& entry = m_entries[m_slots[slot] - 1];
+                    if(entry.m_hash == hash && m_equal(entry.m_key, key))
+                        break;
+                    slot = (slot + 1) & m_mask;
+                }
+                return slot;
+            }
+
+            void unlink(std::size_t index) {
+                std::size_t slot = home(m_entries[index].m_hash);
+                while(m_slots[slot] != index + 1)
+                    slot = (slot + 1) & m_mask;
+
+                for(std::size_t next = (slot + 1) & m_mask; m_slots[next] != 0; next = (next + 1) & m_mask) {
+                    // запись из next можно перенести в slot, если её
+                    // домашний слот не лежит между slot и next
+                    const std::size_t start = home(m_entries[m_slots[next] - 1].m_hash);
+                    const bool between = slot <= next
+                        ? slot < start && start <= next
+                        : slot < start || start <= next;
+                    if(!between) {
+                        m_slots[slot] = m_slots[next];
+                        slot = next;
+                    }
+                }
+                m_slots[slot] = 0;
+            }
+
+            std::size_t victim() {
+                for(;;) {
+                    Entry& entry = m_entries[m_hand];
+                    const std::size_t index = m_hand;
+                    m_hand = (m_hand + 1) % m_capacity;
+                    if(!entry.m_referenced)
+                        return index;
+                    entry.m_referenced = false;
+                }
+            }
+        public:
+            CacheTable(std::size_t capacity, Hash hasher, KeyEqual equal)
+                : m_hasher(std::move(hasher)),
+                  m_equal(std::move(equal)),
+                  m_capacity(capacity == 0 ? 1 : capacity),
+                  m_slots(slotCount(m_capacity), 0),
+                  m_mask(m_slots.size() - 1),
+                  m_hand(0),
+                  m_stats{0, 0, 0, 0} {
+                m_entries.reserve(m_capacity);
+            }
+
+            std::size_t hash(const Key& key) const {
+                return m_hasher(key);
+            }
+
+            /**
+               Значение для key или nullptr. Указатель
+               действителен до следующего insert.
+            */
+            const Value* find(const Key& key, std::size_t hash) {
+                const std::uint32_t index = m_slots[probe(key, hash)];
+                if(index == 0) {
+                    ++m_stats.m_misses;
+                    return nullptr;
+                }
+
+                ++m_stats.m_hits;
+                Entry& entry = m_entries[index - 1];
+                entry.m_referenced = true;
+                return &entry.m_value;
+            }
+
+            template <class TValue>
+            const Value& insert(const Key& key, std::size_t hash, TValue&& value) {
+                std::size_t slot = probe(key, hash);
+                if(m_slots[slot] != 0) {
+                    // пока значение считалось без блокировки, его
+                    // уже добавил другой поток
+                    return m_entries[m_slots[slot] - 1].m_value;
+                }
+
+                std::size_t index = m_entries.size();
+                if(index < m_capacity) {
+                    m_entries.emplace_back(hash, key, std::forward<TValue>(value));
+                } else {
+                    // запись создаётся до вытеснения: если копирование
+                    // ключа или значения бросит, таблица не изменится
+                    Entry entry(hash, key, std::forward<TValue>(value));
+
+                    index = victim();
+                    unlink(index);
+                    slot = probe(key, hash);
+
+                    m_entries[index] = std::move(entry);
+                    ++m_stats.m_evictions;
+                }
+
+                m_slots[slot] = static_cast<std::uint32_t>(index + 1);
+                return m_entries[index].m_value;
+            }
+
+            CacheStats stats() const {
+                CacheStats stats = m_stats;
+                stats.m_size = m_entries.size();
+                return stats;
+            }
+        };
+
+        /**
+           Таблица и функция для одного потока
+        */
+        template <class Func, class Table>
+        class LocalCache final {
+            Func m_func;
+            Table m_table;
+        public:
+            template <class... TArgs>
+            LocalCache(Func func, TArgs&&... args)
+                : m_func(std::move(func)),
+                  m_table(std::forward<TArgs>(args)...) {}
+
+            template <class Key>
+            auto get(const Key& key) {
+                const std::size_t hash = m_table.hash(key);
+                if(auto value = m_table.find(key, hash))
+                    return *value;
+                return m_table.insert(key, hash, m_func(key));
+            }
+
+            CacheStats stats() const {
+                return m_table.stats();
+            }
+        };
+
+        /**
+           Таблица разбитая на части со своими мьютексами.
+           Функция вызывается вне блокировки.
+        */
+        template <class Func, class Table>
+        class ShardedCache final {
+            struct alignas(cache_line_size) Shard {
+                std::mutex m_mutex;
+                Table m_table;
+
+                template <class... TArgs>
+                Shard(TArgs&&... args)
+                    : m_table(std::forward<TArgs>(args)...) {}
+            };
+
+            Func m_func;
+            std::vector<AlignedPtr<Shard>> m_shards;
+        public:
+            template <class Hash, class KeyEqual>
+            ShardedCache(Func func, std::size_t capacity, Hash hasher, KeyEqual equal, std::size_t shards)
+                : m_func(std::move(func)) {
+                if(shards == 0)
+                    shards = 1;
+                for(std::size_t i = 0; i < shards; ++i)
+                    m_shards.push_back(make_aligned<Shard>((capacity + shards - 1) / shards, hasher, equal));
+            }
+
+            template <class Key>
+            auto get(const Key& key) {
+                const std::size_t hash = m_shards.front()->m_table.hash(key);
+                // не те биты, по которым таблица выбирает слот
+                Shard& shard = *m_shards[(cache_mix(hash) >> 16 & 0xFFFF) % m_shards.size()];
+                {
+                    std::lock_guard<std::mutex> lock(shard.m_mutex);
+                    if(auto value = shard.m_table.find(key, hash))
+                        return *value;
+                }
+
+                auto value = m_func(key);
+                std::lock_guard<std::mutex> lock(shard.m_mutex);
+                return shard.m_table.insert(key, hash, std::move(value));
+            }
+
+            CacheStats stats() {
+                CacheStats stats{0, 0, 0, 0};
+                for(auto& shard : m_shards) {
+                    std::lock_guard<std::mutex> lock(shard->m_mutex);
+                    const CacheStats part = shard->m_table.stats();
+                    stats.m_hits += part.m_hits;
+                    stats.m_misses += part.m_misses;
+                    stats.m_evictions += part.m_evictions;
+                    stats.m_size += part.m_size;
+                }
+                return stats;
+            }
+        };
+
+        /**
+           Функциональный объект стадии cache. Хранилище общее
+           для всех копий.
+        */
+        template <class Key, class Store>
+        class CacheStage final {
+            std::shared_ptr<Store> m_store;
+        public:
+            explicit CacheStage(std::shared_ptr<Store> store)
+                : m_store(std::move(store)) {}
+
+            auto operator()(const Key& key) const {
+                return m_store->get(key);
+            }
+
+            CacheStats stats() const {
+                return m_store->stats();
+            }
+        };
+
+        template <class Callable, class Key>
+        using CacheValue = std::decay_t<decltype(std::declval<Callable&>()(std::declval<const Key&>()))>;
+
+        /**
+           Стадия запоминающая до capacity результатов func.
+
+           \tparam Key тип входа стадии
+        */
+        template <class Key,
+                  class Hash = std::hash<Key>,
+                  class KeyEqual = std::equal_to<Key>,
+                  class Func>
+        auto cache(Func&& func, std::size_t capacity, Hash hasher = Hash(), KeyEqual equal = KeyEqual()) {
+            auto callable = pd::function(std::forward<Func>(func));
+            using Callable = decltype(callable);
+            using Table = CacheTable<Key, CacheValue<Callable, Key>, Hash, KeyEqual>;
+            using Store = LocalCache<Callable, Table>;
+            using Stage = CacheStage<Key, Store>;
+            return PipeOp<Stage>(Stage(std::make_shared<Store>(std::move(callable), capacity,
+                                                               std::move(hasher), std::move(equal))));
+        }
+
+        /**
+           Потокобезопасный вариант cache из shards частей.
+           capacity -- общий размер на все части.
+        */
+        template <class Key,
+                  class Hash = std::hash<Key>,
+                  class KeyEqual = std::equal_to<Key>,
+                  class Func>
+        auto sharded_cache(Func&& func, std::size_t capacity, std::size_t shards = 16,
+                           Hash hasher = Hash(), KeyEqual equal = KeyEqual()) {
+            auto callable = pd::function(std::forward<Func>(func));
+            using Callable = decltype(callable);
+            using Table = CacheTable<Key, CacheValue<Callable, Key>, Hash, KeyEqual>;
+            using Store = ShardedCache<Callable, Table>;
+            using Stage = CacheStage<Key, Store>;
+            return PipeOp<Stage>(Stage(std::make_shared<Store>(std::move(callable), capacity,
+                                                               std::move(hasher), std::move(equal), shards)));
+        }
+
+        /**
+           Счётчики стадии созданной cache или sharded_cache
+        */
+        template <class Key, class Store>
+        CacheStats cache_stats(const PipeOp<CacheStage<Key, Store>>& op) {
+            return op.m_func.stats();
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <stdlib.h>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Размер кэш-линии. Используется для выравнивания
+           данных, которые меняют разные потоки.
+        */
+        constexpr std::size_t cache_line_size = 64;
+
+        /**
+           Удаляет объект созданный make_aligned
+        */
+        struct AlignedDelete {
+            template <class T>
+            void operator()(T* value) const {
+                value->~T();
+                std::free(value);
+            }
+        };
+
+        template <class T>
+        using AlignedPtr = std::unique_ptr<T, AlignedDelete>;
+
+        /**
+           Создаёт T в памяти выровненной по alignof(T).
+
+           До C++17 new не учитывает выравнивание больше
+           alignof(std::max_align_t), поэтому объекты с
+           alignas(cache_line_size) создаются через эту функцию.
+        */
+        template <class T, class... Args>
+        AlignedPtr<T> make_aligned(Args&&... args) {
+            void* memory = nullptr;
+            if(posix_memalign(&memory, std::max(alignof(T), sizeof(void*)), sizeof(T)) != 0) {
+#ifdef __cpp_exceptions
+                throw std::bad_alloc();
+#else
+                std::abort();
+#endif /* __cpp_exceptions */
+            }
+
+#ifdef __cpp_exceptions
+            try {
+                return AlignedPtr<T>(new (memory) T(std::forward<Args>(args)...));
+            } catch(...) {
+                std::free(memory);
+                throw;
+            }
+#else
+            return AlignedPtr<T>(new (memory) T(std::forward<Args>(args)...));
+#endif /* __cpp_exceptions */
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -7,7 +7,8 @@
    том какой это объект: функциональный объект, метод или функция.
 
    Callable сам не аллоцирует память и старается использовать семантику
-   перемещения. Т.е. он эффективней чем std::function.
+   перемещения. Т.е. он эффективней чем std::function(замеры в
+   benchmarks/dispatch.cpp).
    Но аллокация может произойти при копировании внутренних структур.
 
    Нет смысла создавать объект Callable напрямую, для создания стоит
@@ -16,6 +17,7 @@
 
 #pragma once
 
+#include <pipeline/details/Ebo.hpp>
 #include <pipeline/details/JustReturn.hpp>
 
 #include <utility>
@@ -40,6 +42,11 @@ namespace pipeline {
            функции
         */
         struct CallableFunction;
+        /**
+           Тег указывающий, что это обёртка для
+           поля класса
+        */
+        struct CallableField;
 
         /**
            Обертка для вызова функционального объекта, метода
@@ -68,22 +75,29 @@ namespace pipeline {
            которые можно вызвать.
         */
         template <class Klass>
-        class Callable<CallableFunctor, Klass, void, void> {
-            Klass m_klass;
+        class Callable<CallableFunctor, Klass, void, void>
+            : private Ebo<Klass, CallableFunctor> {
+            using Storage = Ebo<Klass, CallableFunctor>;
         public:
-            explicit Callable(Klass&& klass)
-                : m_klass(std::forward<Klass>(klass)) {}
+            explicit Callable(Klass klass)
+                : Storage(std::move(klass)) {}
 
             template <class... TArgs>
-            auto operator()(TArgs&&... args) const
+            auto operator()(TArgs&&... args) const &
                 JUST_RETURN(
-                    m_klass(std::forward<TArgs>(args)...)
+                    this->get()(std::forward<TArgs>(args)...)
                     );
 
             template <class... TArgs>
-            auto operator()(TArgs&&... args)
+            auto operator()(TArgs&&... args) &
+                JUST_RETURN(
+                    this->get()(std::forward<TArgs>(args)...)
+                    );
+
+            template <class... TArgs>
+            auto operator()(TArgs&&... args) &&
                 JUST_RETURN(
-                    m_klass(std::forward<TArgs>(args)...)
+                    std::move(*this).Storage::get()(std::forward<TArgs>(args)...)
                     );
         };
 
@@ -146,6 +160,35 @@ namespace pipeline {
                     );
         };
 
+        /**
+           Обёртка для поля класса: возвращает ссылку на
+           поле объекта, переданного первым аргументом
+        */
+        template <class Klass,
+                  class Ret>
+        class Callable<CallableField, Klass, Ret, void> {
+            using FieldPtr = Ret Klass::*;
+            FieldPtr m_field;
+        public:
+            explicit Callable(FieldPtr field)
+                : m_field(field) {}
+
+            auto operator()(const Klass& klass) const
+                JUST_RETURN(
+                    klass.*m_field
+                    );
+
+            auto operator()(Klass& klass) const
+                JUST_RETURN(
+                    klass.*m_field
+                    );
+
+            auto operator()(Klass&& klass) const
+                JUST_RETURN(
+                    std::move(klass).*m_field
+                    );
+        };
+
         /**
            Обёртка для функции.
         */
@@ -171,6 +214,59 @@ namespace pipeline {
                     );
         };
 
+        /**
+           Вызов функции или метода известного на этапе компиляции.
+           Специализируется по типу указателя.
+
+           Тип функции и метода не разбирается на части, поэтому
+           подходят и noexcept функции(в C++17 это часть типа), и
+           методы с любыми const, & и && -- как в std::invoke.
+           Метод вызывается только для объекта, для которого его
+           можно вызвать: неконстантный метод не вызывается для
+           const объекта, метод с && -- для lvalue.
+        */
+        template <class Ptr>
+        struct StaticInvoke;
+
+        template <class Function>
+        struct StaticInvoke<Function*> {
+            template <Function* function, class... TArgs>
+            static auto call(TArgs&&... args)
+                JUST_RETURN(
+                    function(std::forward<TArgs>(args)...)
+                    );
+        };
+
+        template <class Method,
+                  class Klass>
+        struct StaticInvoke<Method Klass::*> {
+            template <Method Klass::*method, class Object, class... TArgs>
+            static auto call(Object&& object, TArgs&&... args)
+                JUST_RETURN(
+                    (std::forward<Object>(object).*method)(std::forward<TArgs>(args)...)
+                    );
+        };
+
+        /**
+           Обёртка для функции или метода переданного через
+           параметр шаблона.
+
+           В отличии от Callable<CallableFunction, ...> и
+           Callable<CallableMethod, ...> указатель является частью
+           типа, а не хранится в объекте. Поэтому объект пустой, а
+           вызов всегда прямой и не зависит от того, увидит ли
+           оптимизатор значение указателя.
+        */
+        template <class Ptr, Ptr ptr>
+        class StaticCallable {
+        public:
+            template <class... TArgs>
+            auto operator()(TArgs&&... args) const
+                JUST_RETURN(
+                    StaticInvoke<Ptr>::template call<ptr>(std::forward<TArgs>(args)...)
+                    );
+        };
+
         /**
            Функция для создания Callable для функционального
            объекта(класса или лямбды)
@@ -178,7 +274,7 @@ namespace pipeline {
         template <class Klass>
         auto function(Klass&& t) {
             return Callable<CallableFunctor,
-                            std::remove_reference_t<Klass>,
+                            std::decay_t<Klass>,
                             void, void>(std::forward<Klass>(t));
         }
 
@@ -200,6 +296,15 @@ namespace pipeline {
             return Callable<CallableMethod, const Klass, Ret, Args...>(t);
         }
 
+        /**
+           Функция для создания Callable для поля класса
+        */
+        template <class Ret, class Klass,
+                  class = std::enable_if_t<!std::is_function<Ret>::value>>
+        auto function(Ret Klass::*t) {
+            return Callable<CallableField, Klass, Ret, void>(t);
+        }
+
         /**
            Функция для создания Callable для функции
         */
@@ -208,6 +313,14 @@ namespace pipeline {
             return Callable<CallableFunction, void, Ret, Args...>(t);
         }
 
+        /**
+           Функция для создания StaticCallable: function<decltype(&f), &f>()
+        */
+        template <class Ptr, Ptr ptr>
+        auto function() {
+            return StaticCallable<Ptr, ptr>();
+        }
+
     } /* namespace details */
 
 } /* namespace pipeline */
@@ -0,0 +1,169 @@
+/**
+   \file
+
+   Composed -- это композиция двух функциональных объектов:
+   сначала вызывается первый, его результат передаётся во второй.
+
+   Композиция всегда хранится вложенной вправо: (a . b) . c
+   превращается в a . (b . c). Так вызов цепочки выглядит как
+   c(b(a(x))) и разворачивается компилятором в те же вложенные
+   вызовы, что и написанные руками. А если a вернул пустой Maybe,
+   то одна проверка пропускает сразу весь остаток b . c(см.
+   Maybe.hpp).
+
+   Не имеет смысла создавать Composed напрямую. Для создания нужно
+   использовать функцию compose.
+*/
+
+#pragma once
+
+#include <pipeline/details/Ebo.hpp>
+#include <pipeline/details/JustReturn.hpp>
+#include <pipeline/details/Maybe.hpp>
+#include <pipeline/details/Namespaces.hpp>
+
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Теги для хранилищ Ebo внутри Composed. Owner -- сам
+           Composed: у вложенной композиции с тем же пустым типом
+           свои теги, иначе базовые классы Ebo совпадут.
+        */
+        template <class Owner>
+        struct ComposedFirst;
+
+        template <class Owner>
+        struct ComposedSecond;
+
+        /**
+           Вызывает First, а затем Second с результатом First.
+
+           Пустые First и Second не занимают места. Composed не
+           помечен final, чтобы вложенная композиция тоже могла
+           храниться как пустой базовый класс.
+
+           \tparam First функциональный объект который вызывается
+           первым
+           \tparam Second функциональный объект который получает
+           результат First
+        */
+        template <class First,
+                  class Second>
+        class Composed
+            : private Ebo<First, ComposedFirst<Composed<First, Second>>>,
+              private Ebo<Second, ComposedSecond<Composed<First, Second>>> {
+            using FirstStorage = Ebo<First, ComposedFirst<Composed>>;
+            using SecondStorage = Ebo<Second, ComposedSecond<Composed>>;
+        public:
+            template <class TFirst,
+                      class TSecond>
+            Composed(TFirst&& first,
+                     TSecond&& second)
+                : FirstStorage(std::forward<TFirst>(first)),
+                  SecondStorage(std::forward<TSecond>(second)) {}
+
+            First& first() & {
+                return FirstStorage::get();
+            }
+
+            const First& first() const & {
+                return FirstStorage::get();
+            }
+
+            First&& first() && {
+                return std::move(*this).FirstStorage::get();
+            }
+
+            Second& second() & {
+                return SecondStorage::get();
+            }
+
+            const Second& second() const & {
+                return SecondStorage::get();
+            }
+
+            Second&& second() && {
+                return std::move(*this).SecondStorage::get();
+            }
+
+            template <class TArg>
+            auto operator()(TArg&& arg) const &
+                JUST_RETURN(
+                    pd::pipe_call(this->second(), this->first()(std::forward<TArg>(arg)))
+                    );
+
+            template <class TArg>
+            auto operator()(TArg&& arg) &
+                JUST_RETURN(
+                    pd::pipe_call(this->second(), this->first()(std::forward<TArg>(arg)))
+                    );
+
+            /**
+               Временная композиция вызывает обе части как rvalue.
+               Каждая часть перемещается только один раз.
+            */
+            template <class TArg>
+            auto operator()(TArg&& arg) &&
+                JUST_RETURN(
+                    pd::pipe_call(std::move(*this).second(),
+                                  std::move(*this).first()(std::forward<TArg>(arg)))
+                    );
+        };
+
+        template <class T>
+        struct IsComposed : std::false_type {};
+
+        template <class First,
+                  class Second>
+        struct IsComposed<Composed<First, Second>> : std::true_type {};
+
+        template <class Left, class Right>
+        auto compose(Left&& left, Right&& right);
+
+        /**
+           Вспомогательный класс для compose. Выбирает
+           способ соединения по тому, является ли левая часть
+           композицией.
+        */
+        class Compose {
+        public:
+            template <class Left, class Right>
+            static auto make(Left&& left, Right&& right, std::false_type) {
+                return Composed<std::decay_t<Left>,
+                                std::decay_t<Right>>(std::forward<Left>(left),
+                                                     std::forward<Right>(right));
+            }
+
+            /**
+               (a . b) . c превращается в a . (b . c)
+            */
+            template <class Left, class Right>
+            static auto make(Left&& left, Right&& right, std::true_type) {
+                using First = std::decay_t<decltype(left.first())>;
+
+                auto rest = pd::compose(std::forward<Left>(left).second(),
+                                        std::forward<Right>(right));
+                return Composed<First,
+                                decltype(rest)>(std::forward<Left>(left).first(),
+                                                std::move(rest));
+            }
+        };
+
+        /**
+           Функция для создания Composed
+        */
+        template <class Left, class Right>
+        auto compose(Left&& left, Right&& right) {
+            return Compose::make(std::forward<Left>(left),
+                                 std::forward<Right>(right),
+                                 IsComposed<std::decay_t<Left>>());
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
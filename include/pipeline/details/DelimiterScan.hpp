@@ -0,0 +1,178 @@
+/**
+   \file
+
+   Поиск всех разделителей в буфере с помощью SSE2 и AVX2.
+
+   Буфер обрабатывается блоками по delimiter_block байт. Для блока
+   ядро сравнивает сразу 32 или 64 байта с разделителем, получает
+   битовую маску совпадений и выписывает смещения всех разделителей
+   блока в массив. Для коротких строк(логи, CSV) это быстрее чем
+   вызывать memchr для каждой записи.
+
+   Ядро выбирается один раз во время выполнения(см. SimdLevel.hpp).
+   Для AVX-512 используется ядро AVX2.
+*/
+
+#pragma once
+
+#include <pipeline/details/SimdLevel.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Размер блока. Смещения внутри блока помещаются
+           в std::uint16_t.
+        */
+        constexpr std::size_t delimiter_block = 4096;
+
+        /**
+           Ядро поиска: записывает в positions смещения всех delim
+           в [data, data + size), size <= delimiter_block.
+
+           \return число найденных разделителей
+        */
+        using DelimiterKernel = std::size_t (*)(const char* data, std::size_t size, char delim,
+                                                std::uint16_t* positions);
+
+        /**
+           Скалярный поиск в [data + begin, data + size),
+           дописывает смещения после count первых
+        */
+        inline std::size_t find_delimiters_from(const char* data, std::size_t begin, std::size_t size,
+                                                char delim, std::uint16_t* positions, std::size_t count) {
+            for(std::size_t i = begin; i < size; ++i) {
+                // без ветвления: запись делается всегда, а
+                // счётчик растёт только на разделителе
+                positions[count] = static_cast<std::uint16_t>(i);
+                count += data[i] == delim;
+            }
+            return count;
+        }
+
+        /**
+           Ядро без SIMD. memchr в стандартной библиотеке
+           обычно сам векторизован.
+        */
+        inline std::size_t find_delimiters_scalar(const char* data, std::size_t size, char delim,
+                                                  std::uint16_t* positions) {
+            std::size_t count = 0;
+            const char* const end = data + size;
+            for(const char* found = data;
+                (found = static_cast<const char*>(std::memchr(found, delim, end - found))) != nullptr;
+                ++found)
+                positions[count++] = static_cast<std::uint16_t>(found - data);
+            return count;
+        }
+
+#ifdef PIPELINE_X86_SIMD
+        /**
+           Выписывает позиции единичных битов mask,
+           начиная со смещения offset
+        */
+        inline std::size_t write_positions(std::uint64_t mask, std::size_t offset,
+                                           std::uint16_t* positions, std::size_t count) {
+            while(mask != 0) {
+                positions[count++] = static_cast<std::uint16_t>(offset + __builtin_ctzll(mask));
+                mask &= mask - 1;
+            }
+            return count;
+        }
+
+        inline std::size_t find_delimiters_sse2(const char* data, std::size_t size, char delim,
+                                                std::uint16_t* positions) {
+            const __m128i pattern = _mm_set1_epi8(delim);
+            std::size_t count = 0;
+            std::size_t i = 0;
+            // по 32 байта: одна маска на две загрузки
+            for(; i + 32 <= size; i += 32) {
+                const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+                const std::uint64_t mask =
+                    static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(low, pattern))) |
+                    static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(high, pattern))) << 16;
+                count = write_positions(mask, i, positions, count);
+            }
+            return find_delimiters_from(data, i, size, delim, positions, count);
+        }
+
+        __attribute__((target("avx2")))
+        inline std::size_t find_delimiters_avx2(const char* data, std::size_t size, char delim,
+                                                std::uint16_t* positions) {
+            const __m256i pattern = _mm256_set1_epi8(delim);
+            std::size_t count = 0;
+            std::size_t i = 0;
+            // по 64 байта: одна маска на две загрузки
+            for(; i + 64 <= size; i += 64) {
+                const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+                const std::uint64_t mask =
+                    static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, pattern))) |
+                    static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+                        _mm256_movemask_epi8(_mm256_cmpeq_epi8(high, pattern)))) << 32;
+                count = write_positions(mask, i, positions, count);
+            }
+            return find_delimiters_from(data, i, size, delim, positions, count);
+        }
+#endif /* PIPELINE_X86_SIMD */
+
+        /**
+           Ядро для уровня level. Уровень не должен быть выше
+           best_simd_level().
+        */
+        inline DelimiterKernel delimiter_kernel(SimdLevel level) {
+            switch(level) {
+#ifdef PIPELINE_X86_SIMD
+            case SimdLevel::avx512:
+            case SimdLevel::avx2:
+                return find_delimiters_avx2;
+            case SimdLevel::sse2:
+                return find_delimiters_sse2;
+#endif /* PIPELINE_X86_SIMD */
+            default:
+                return find_delimiters_scalar;
+            }
+        }
+
+        inline DelimiterKernel delimiter_kernel() {
+            static const DelimiterKernel kernel = delimiter_kernel(best_simd_level());
+            return kernel;
+        }
+
+        /**
+           Вызывает func(begin, end) для каждой записи буфера
+           разделённой delim. Правила те же что у records: остаток
+           после последнего разделителя -- тоже запись, пустой
+           буфер не даёт записей.
+
+           \return false если func вернул false
+        */
+        template <class Func>
+        bool scan_records(const char* data, std::size_t size, char delim, Func&& func,
+                          DelimiterKernel kernel = delimiter_kernel()) {
+            std::uint16_t positions[delimiter_block];
+            const char* record = data;
+            for(std::size_t block = 0; block < size; block += delimiter_block) {
+                const std::size_t length = size - block < delimiter_block ? size - block : delimiter_block;
+                const char* const begin = data + block;
+                const std::size_t count = kernel(begin, length, delim, positions);
+                for(std::size_t i = 0; i < count; ++i) {
+                    const char* const end = begin + positions[i];
+                    if(!func(record, end))
+                        return false;
+                    record = end + 1;
+                }
+            }
+            if(record != data + size)
+                return func(record, data + size);
+            return true;
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
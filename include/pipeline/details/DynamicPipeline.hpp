@@ -0,0 +1,252 @@
+/**
+   \file
+
+   DynamicPipeline -- цепочка стадий T(T) собираемая во время
+   выполнения:
+   \code
+   DynamicPipeline<Record> rules;
+   for(const auto& rule : config)
+       rules.append(make_rule(rule));
+   auto result = records | map(std::cref(rules)) | to_vector;
+   \endcode
+
+   Все стадии лежат в одном непрерывном буфере друг за другом:
+   сначала заголовок с указателями на функции вызова и
+   перемещения, затем сам объект стадии. Вызов цепочки -- это
+   один цикл, который идёт по буферу подряд, поэтому стадии не
+   разбросаны по куче и не промахиваются мимо кэша на каждом
+   элементе.
+
+   Стадия попадает в кучу только если её перемещение может
+   бросить исключение или её выравнивание больше чем у
+   std::max_align_t. Тогда в буфере хранится указатель на неё.
+
+   T должен иметь перемещающее присваивание: результат каждой
+   стадии присваивается одной и той же переменной.
+*/
+
+#pragma once
+
+#include <pipeline/details/AnyFunction.hpp>
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+    namespace details {
+
+        template <class T>
+        class DynamicPipeline final {
+            using Param = std::conditional_t<std::is_scalar<T>::value, T, T&&>;
+            using Block = std::aligned_storage_t<alignof(std::max_align_t), alignof(std::max_align_t)>;
+
+            /**
+               Заголовок стадии в буфере. Сразу за ним лежит
+               объект стадии.
+
+               m_manage перемещает объект из from в to, или удаляет
+               объект в from если to равен nullptr.
+            */
+            struct Header {
+                T (*m_call)(void*, Param);
+                void (*m_manage)(void*, void*);
+                std::size_t m_next;
+            };
+
+            static constexpr std::size_t roundUp(std::size_t size) {
+                return (size + sizeof(Block) - 1) / sizeof(Block) * sizeof(Block);
+            }
+
+            static constexpr std::size_t header_size =
+                (sizeof(Header) + sizeof(Block) - 1) / sizeof(Block) * sizeof(Block);
+
+            template <class Func>
+            using Storage = AnyStorage<Func,
+                                       alignof(Func) <= alignof(Block) &&
+                                       std::is_nothrow_move_constructible<Func>::value>;
+
+            template <class Func>
+            static T call(void* object, Param value) {
+                return Storage<Func>::get(object)(std::forward<T>(value));
+            }
+
+            template <class Func>
+            static void manage(void* from, void* to) {
+                if(to)
+                    Storage<Func>::move(from, to);
+                else
+                    Storage<Func>::destroy(from);
+            }
+
+            template <class Func>
+            static constexpr std::size_t recordSize() {
+                return header_size + roundUp(Storage<Func>::size);
+            }
+
+            std::unique_ptr<Block[]> m_blocks;
+            std::size_t m_size;
+            std::size_t m_capacity;
+            std::size_t m_count;
+
+            unsigned char* data() const {
+                return reinterpret_cast<unsigned char*>(m_blocks.get());
+            }
+
+            static Header& header(unsigned char* record) {
+                return *reinterpret_cast<Header*>(record);
+            }
+
+            /**
+               Переносит стадии в новый буфер не меньше capacity байт
+            */
+            void grow(std::size_t capacity) {
+                capacity = std::max(capacity, 2 * m_capacity);
+                std::unique_ptr<Block[]> blocks(new Block[capacity / sizeof(Block)]);
+                unsigned char* to = reinterpret_cast<unsigned char*>(blocks.get());
+
+                for(std::size_t offset = 0; offset < m_size; ) {
+                    unsigned char* from = data() + offset;
+                    const Header& old = header(from);
+                    new (to + offset) Header(old);
+                    old.m_manage(from + header_size, to + offset + header_size);
+                    offset += old.m_next;
+                }
+
+                m_blocks = std::move(blocks);
+                m_capacity = capacity;
+            }
+        public:
+            DynamicPipeline()
+                : m_size(0),
+                  m_capacity(0),
+                  m_count(0) {}
+
+            DynamicPipeline(DynamicPipeline&& other) noexcept
+                : m_blocks(std::move(other.m_blocks)),
+                  m_size(other.m_size),
+                  m_capacity(other.m_capacity),
+                  m_count(other.m_count) {
+                other.m_size = 0;
+                other.m_capacity = 0;
+                other.m_count = 0;
+            }
+
+            DynamicPipeline& operator=(DynamicPipeline&& other) noexcept {
+                if(this != &other) {
+                    clear();
+                    m_blocks = std::move(other.m_blocks);
+                    m_size = other.m_size;
+                    m_capacity = other.m_capacity;
+                    m_count = other.m_count;
+                    other.m_size = 0;
+                    other.m_capacity = 0;
+                    other.m_count = 0;
+                }
+                return *this;
+            }
+
+            DynamicPipeline(const DynamicPipeline&) = delete;
+            DynamicPipeline& operator=(const DynamicPipeline&) = delete;
+
+            ~DynamicPipeline() {
+                clear();
+            }
+
+            /**
+               Добавляет стадию в конец цепочки. func может быть
+               PipeOp, функцией, методом или функциональным
+               объектом, так же как и в pipe_op.
+            */
+            template <class Func>
+            DynamicPipeline& append(Func&& func) {
+                auto callable = pd::function(std::forward<Func>(func));
+                using Stage = decltype(callable);
+
+                const std::size_t size = recordSize<Stage>();
+                if(m_size + size > m_capacity)
+                    grow(m_size + size);
+
+                unsigned char* record = data() + m_size;
+                Storage<Stage>::create(record + header_size, std::move(callable));
+                new (record) Header{&call<Stage>, &manage<Stage>, size};
+
+                m_size += size;
+                ++m_count;
+                return *this;
+            }
+
+            /**
+               Заранее выделяет bytes байт под стадии
+            */
+            void reserve(std::size_t bytes) {
+                bytes = roundUp(bytes);
+                if(bytes > m_capacity)
+                    grow(bytes);
+            }
+
+            /**
+               Удаляет все стадии, буфер остаётся
+            */
+            void clear() {
+                for(std::size_t offset = 0; offset < m_size; ) {
+                    unsigned char* record = data() + offset;
+                    const Header& current = header(record);
+                    current.m_manage(record + header_size, nullptr);
+                    offset += current.m_next;
+                }
+                m_size = 0;
+                m_count = 0;
+            }
+
+            std::size_t size() const {
+                return m_count;
+            }
+
+            bool empty() const {
+                return m_count == 0;
+            }
+
+            /**
+               Сколько байт буфера занимают стадии
+            */
+            std::size_t bytes() const {
+                return m_size;
+            }
+
+            /**
+               Пропускает value через все стадии по порядку.
+
+               Как и у AnyFunction, стадии вызываются как не
+               константные объекты.
+            */
+            T operator()(T value) const {
+                unsigned char* record = data();
+                unsigned char* const end = record + m_size;
+                while(record != end) {
+                    const Header& current = header(record);
+                    value = current.m_call(record + header_size, std::forward<T>(value));
+                    record += current.m_next;
+                }
+                return value;
+            }
+        };
+
+        /**
+           Этот пайп передаёт объект в DynamicPipeline:
+           record | rules
+        */
+        template <class TValue, class T>
+        T operator|(TValue&& value, const DynamicPipeline<T>& pipeline) {
+            return pipeline(std::forward<TValue>(value));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,72 @@
+/**
+   \file
+
+   Ebo -- хранилище для объекта с оптимизацией пустого базового
+   класса(empty base optimization).
+
+   Если тип пустой(например функция переданная через параметр
+   шаблона или лямбда без захвата), то он хранится как базовый
+   класс и не занимает места. Иначе -- как обычное поле.
+
+   Tag нужен для того, чтобы один класс мог хранить несколько
+   Ebo с одинаковым T.
+*/
+
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+    namespace details {
+
+        template <class T,
+                  class Tag,
+                  bool = std::is_empty<T>::value && !std::is_final<T>::value>
+        class Ebo {
+            T m_value;
+        public:
+            template <class TValue,
+                      class = std::enable_if_t<!std::is_same<std::decay_t<TValue>, Ebo>::value>>
+            explicit constexpr Ebo(TValue&& value)
+                : m_value(std::forward<TValue>(value)) {}
+
+            T& get() & {
+                return m_value;
+            }
+
+            constexpr const T& get() const & {
+                return m_value;
+            }
+
+            T&& get() && {
+                return std::move(m_value);
+            }
+        };
+
+        template <class T,
+                  class Tag>
+        class Ebo<T, Tag, true> : private T {
+        public:
+            template <class TValue,
+                      class = std::enable_if_t<!std::is_same<std::decay_t<TValue>, Ebo>::value>>
+            explicit constexpr Ebo(TValue&& value)
+                : T(std::forward<TValue>(value)) {}
+
+            T& get() & {
+                return *this;
+            }
+
+            constexpr const T& get() const & {
+                return *this;
+            }
+
+            T&& get() && {
+                return std::move(*this);
+            }
+        };
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,329 @@
+/**
+   \file
+
+   EventLoop -- однопоточный исполнитель для сопрограмм.
+
+   Сопрограммы запускаются через spawn, а run выполняет их в
+   вызывающем потоке, пока все они не завершатся. Сопрограмма,
+   которая ждёт, не занимает поток: тысячи конвейеров в ожидании
+   ввода-вывода обходятся одним потоком.
+
+   offload(f) выполняет блокирующую функцию f(например чтение
+   файла) в ThreadPool и возобновляет ждущую сопрограмму снова в
+   потоке EventLoop. offload -- это тоже сопрограмма: f и
+   результат хранятся в её кадре, а объект ожидания содержит
+   только указатели(см. замечание о GCC 12 в Task.hpp).
+
+   schedule() переносит сопрограмму в поток EventLoop. Если она
+   уже в нём, то ожидания нет. Этот метод нужен стадии async(см.
+   Async.hpp), а также позволяет использовать EventLoop вместе с
+   другими исполнителями.
+
+   \code
+   EventLoop loop;
+   for(const auto& path : paths)
+       loop.spawn(path | async(read_file, loop) | async(parse, loop) | async(store, loop));
+   loop.run();
+   \endcode
+
+   Только для C++20.
+*/
+
+#pragma once
+
+#include <pipeline/details/Task.hpp>
+#include <pipeline/details/ThreadPool.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifdef __cpp_lib_coroutine
+
+namespace pipeline {
+
+    namespace details {
+
+        class EventLoop final {
+            /**
+               Сопрограмма запущенная через spawn. Уничтожает
+               себя сама после завершения.
+            */
+            struct Detached {
+                struct promise_type {
+                    Detached get_return_object() {
+                        return Detached{std::coroutine_handle<promise_type>::from_promise(*this)};
+                    }
+
+                    std::suspend_always initial_suspend() noexcept {
+                        return {};
+                    }
+
+                    std::suspend_never final_suspend() noexcept {
+                        return {};
+                    }
+
+                    void return_void() {}
+
+                    void unhandled_exception() {
+                        std::terminate();
+                    }
+                };
+
+                std::coroutine_handle<promise_type> m_handle;
+            };
+
+            class Schedule {
+                EventLoop& m_loop;
+            public:
+                explicit Schedule(EventLoop& loop)
+                    : m_loop(loop) {}
+
+                bool await_ready() const noexcept {
+                    return m_loop.inLoopThread();
+                }
+
+                void await_suspend(std::coroutine_handle<> handle) {
+                    m_loop.post(handle);
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            /**
+               Ожидание задачи в пуле. Хранит только указатели
+               на состояние в кадре сопрограммы offload.
+            */
+            template <class Func, class Stored>
+            class Offload {
+                EventLoop* m_loop;
+                Func* m_func;
+                std::optional<Stored>* m_result;
+                std::exception_ptr* m_error;
+                std::coroutine_handle<> m_handle;
+
+                void call() {
+                    if constexpr(std::is_void<std::invoke_result_t<Func&>>::value) {
+                        (*m_func)();
+                        m_result->emplace(true);
+                    } else {
+                        m_result->emplace((*m_func)());
+                    }
+                }
+
+                static void run(void* context, std::size_t, std::size_t) {
+                    Offload& self = *static_cast<Offload*>(context);
+#ifdef __cpp_exceptions
+                    try {
+                        self.call();
+                    } catch(...) {
+                        *self.m_error = std::current_exception();
+                    }
+#else
+                    self.call();
+#endif /* __cpp_exceptions */
+                    self.m_loop->post(self.m_handle);
+                }
+            public:
+                Offload(EventLoop* loop, Func* func, std::optional<Stored>* result, std::exception_ptr* error)
+                    : m_loop(loop),
+                      m_func(func),
+                      m_result(result),
+                      m_error(error) {}
+
+                bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> handle) {
+                    m_handle = handle;
+                    const ThreadPool::Task task{&Offload::run, this, 0, 1};
+                    m_loop->m_pool.submit(&task, 1);
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            ThreadPool& m_pool;
+
+            /**
+               Сопрограмма в очереди. m_spawned -- кадр Detached,
+               который ещё не запускался: им владеет очередь.
+            */
+            struct Ready {
+                std::coroutine_handle<> m_handle;
+                bool m_spawned;
+            };
+
+            std::mutex m_mutex;
+            std::condition_variable m_wakeup;
+            std::deque<Ready> m_ready;
+            std::size_t m_running;
+            std::exception_ptr m_error;
+
+            std::atomic<std::thread::id> m_thread;
+
+            bool inLoopThread() const {
+                return m_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+            }
+
+            template <class T>
+            static Detached detach(EventLoop& loop, Task<T> task) {
+                std::exception_ptr error;
+#ifdef __cpp_exceptions
+                try {
+                    co_await std::move(task);
+                } catch(...) {
+                    error = std::current_exception();
+                }
+#else
+                co_await std::move(task);
+#endif /* __cpp_exceptions */
+                loop.finish(error);
+            }
+
+            void finish(std::exception_ptr error) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(error && !m_error)
+                    m_error = error;
+                --m_running;
+            }
+
+            template <class T>
+            static Task<void> store(Task<T> task, std::optional<T>& result) {
+                T value = co_await std::move(task);
+                result.emplace(std::move(value));
+            }
+        public:
+            explicit EventLoop(ThreadPool& pool = ThreadPool::instance())
+                : m_pool(pool),
+                  m_running(0) {}
+
+            EventLoop(const EventLoop&) = delete;
+            EventLoop& operator=(const EventLoop&) = delete;
+
+            /**
+               Уничтожает сопрограммы запущенные через spawn, но
+               не выполненные: run не вызывался. Остальные кадры
+               принадлежат своим вызывающим сопрограммам.
+            */
+            ~EventLoop() {
+                for(const Ready& ready : m_ready) {
+                    if(ready.m_spawned)
+                        ready.m_handle.destroy();
+                }
+            }
+
+            /**
+               Ставит сопрограмму в очередь. Можно вызывать
+               из любого потока.
+
+               notify_one под блокировкой: иначе run может
+               завершиться и EventLoop будет уничтожен раньше,
+               чем поток пула дойдёт до m_wakeup.
+            */
+            void post(std::coroutine_handle<> handle) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_ready.push_back(Ready{handle, false});
+                m_wakeup.notify_one();
+            }
+
+            /**
+               Запускает task. Результат task отбрасывается, а
+               первое исключение бросается из run.
+            */
+            template <class T>
+            void spawn(Task<T> task) {
+                Detached detached = detach(*this, std::move(task));
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_running;
+                m_ready.push_back(Ready{detached.m_handle, true});
+                m_wakeup.notify_one();
+            }
+
+            /**
+               Выполняет сопрограммы в этом потоке, пока все
+               запущенные не завершатся
+            */
+            void run() {
+                m_thread.store(std::this_thread::get_id());
+                for(;;) {
+                    std::coroutine_handle<> handle;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_wakeup.wait(lock, [this] { return !m_ready.empty() || m_running == 0; });
+                        if(m_ready.empty())
+                            break;
+                        handle = m_ready.front().m_handle;
+                        m_ready.pop_front();
+                    }
+                    handle.resume();
+                }
+                m_thread.store(std::thread::id());
+
+                std::exception_ptr error;
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    error = std::exchange(m_error, nullptr);
+                }
+                if(error)
+                    std::rethrow_exception(error);
+            }
+
+            /**
+               Запускает task, выполняет все сопрограммы и
+               возвращает результат task
+            */
+            template <class T>
+            T run(Task<T> task) {
+                if constexpr(std::is_void<T>::value) {
+                    spawn(std::move(task));
+                    run();
+                } else {
+                    std::optional<T> result;
+                    spawn(store(std::move(task), result));
+                    run();
+                    return std::move(*result);
+                }
+            }
+
+            /**
+               Переносит сопрограмму в поток EventLoop:
+               co_await loop.schedule()
+            */
+            Schedule schedule() {
+                return Schedule(*this);
+            }
+
+            /**
+               Выполняет func в пуле потоков:
+               auto text = co_await loop.offload([&] { return read(path); })
+            */
+            template <class Func,
+                      class Result = std::invoke_result_t<std::decay_t<Func>&>>
+            Task<Result> offload(Func func) {
+                using Stored = std::conditional_t<std::is_void<Result>::value, bool, Result>;
+
+                std::optional<Stored> result;
+                std::exception_ptr error;
+                co_await Offload<Func, Stored>(this, &func, &result, &error);
+
+                if(error)
+                    std::rethrow_exception(error);
+                if constexpr(!std::is_void<Result>::value)
+                    co_return std::move(*result);
+            }
+        };
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_coroutine */
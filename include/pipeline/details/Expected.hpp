@@ -0,0 +1,236 @@
+/**
+   \file
+
+   Expected<T, E> -- либо значение T, либо ошибка E. Замена
+   исключениям для стадий, которые могут не справиться с входными
+   данными:
+   \code
+   Expected<Record, std::error_code> parse(const std::string& line) {
+       if(line.empty())
+           return make_unexpected(std::make_error_code(std::errc::invalid_argument));
+       return Record(line);
+   }
+
+   auto result = line | pipe_op(parse) | pipe_op(enrich) | pipe_op(encode);
+   // result -- Expected<..., std::error_code>
+   \endcode
+
+   Expected подключён к каналу Maybe(см. Maybe.hpp): если стадия
+   вернула ошибку, то остальные стадии не вызываются, а ошибка
+   переносится в результат. В композиции op1 | op2 | op3 для этого
+   нужна одна проверка на всю оставшуюся цепочку, без раскрутки
+   стека как у исключений.
+
+   Пустого состояния у Expected нет, поэтому стадия возвращающая
+   Expected не может принимать значение из std::optional или
+   указателя: для пустого входа нечем заполнить ошибку. Такая
+   цепочка не компилируется(static_assert в Maybe.hpp).
+*/
+
+#pragma once
+
+#include <pipeline/details/Maybe.hpp>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Ошибка для создания Expected: return make_unexpected(error);
+        */
+        template <class E>
+        class Unexpected final {
+            E m_error;
+        public:
+            explicit Unexpected(E error)
+                : m_error(std::move(error)) {}
+
+            E& error() & {
+                return m_error;
+            }
+
+            const E& error() const & {
+                return m_error;
+            }
+
+            E&& error() && {
+                return std::move(m_error);
+            }
+        };
+
+        template <class T>
+        struct IsUnexpected : std::false_type {};
+
+        template <class E>
+        struct IsUnexpected<Unexpected<E>> : std::true_type {};
+
+        /**
+           Функция для создания Unexpected
+        */
+        template <class E>
+        auto make_unexpected(E&& error) {
+            return Unexpected<std::decay_t<E>>(std::forward<E>(error));
+        }
+
+        /**
+           Значение T или ошибка E.
+
+           Для доступа к значению и ошибке нет проверяющих
+           методов которые бросают исключения: перед operator*
+           нужно проверить has_value(), перед error() -- что
+           значения нет.
+        */
+        template <class T, class E>
+        class Expected final {
+            union {
+                T m_value;
+                E m_error;
+            };
+            bool m_has_value;
+
+            template <class Other>
+            void construct(Other&& other) {
+                if(other.m_has_value)
+                    new (&m_value) T(std::forward<Other>(other).m_value);
+                else
+                    new (&m_error) E(std::forward<Other>(other).m_error);
+                m_has_value = other.m_has_value;
+            }
+
+            template <class Other>
+            void assign(Other&& other) {
+                if(m_has_value && other.m_has_value) {
+                    m_value = std::forward<Other>(other).m_value;
+                } else if(!m_has_value && !other.m_has_value) {
+                    m_error = std::forward<Other>(other).m_error;
+                } else {
+                    destroy();
+                    construct(std::forward<Other>(other));
+                }
+            }
+
+            void destroy() {
+                if(m_has_value)
+                    m_value.~T();
+                else
+                    m_error.~E();
+            }
+        public:
+            using value_type = T;
+            using error_type = E;
+
+            template <class U = T,
+                      class = std::enable_if_t<std::is_constructible<T, U&&>::value &&
+                                               !std::is_same<std::decay_t<U>, Expected>::value &&
+                                               !IsUnexpected<std::decay_t<U>>::value>>
+            Expected(U&& value)
+                : m_value(std::forward<U>(value)),
+                  m_has_value(true) {}
+
+            template <class G>
+            Expected(const Unexpected<G>& error)
+                : m_error(error.error()),
+                  m_has_value(false) {}
+
+            template <class G>
+            Expected(Unexpected<G>&& error)
+                : m_error(std::move(error).error()),
+                  m_has_value(false) {}
+
+            Expected(const Expected& other) {
+                construct(other);
+            }
+
+            Expected(Expected&& other) noexcept(std::is_nothrow_move_constructible<T>::value &&
+                                                std::is_nothrow_move_constructible<E>::value) {
+                construct(std::move(other));
+            }
+
+            Expected& operator=(const Expected& other) {
+                if(this != &other)
+                    assign(other);
+                return *this;
+            }
+
+            Expected& operator=(Expected&& other) {
+                if(this != &other)
+                    assign(std::move(other));
+                return *this;
+            }
+
+            ~Expected() {
+                destroy();
+            }
+
+            bool has_value() const {
+                return m_has_value;
+            }
+
+            explicit operator bool() const {
+                return m_has_value;
+            }
+
+            T& operator*() & {
+                return m_value;
+            }
+
+            const T& operator*() const & {
+                return m_value;
+            }
+
+            T&& operator*() && {
+                return std::move(m_value);
+            }
+
+            T* operator->() {
+                return &m_value;
+            }
+
+            const T* operator->() const {
+                return &m_value;
+            }
+
+            E& error() & {
+                return m_error;
+            }
+
+            const E& error() const & {
+                return m_error;
+            }
+
+            E&& error() && {
+                return std::move(m_error);
+            }
+        };
+
+    } /* namespace details */
+
+    /**
+       Expected в канале Maybe. Пустой результат стадии
+       получает ошибку входного Expected.
+    */
+    template <class T, class E>
+    struct MaybeTraits<details::Expected<T, E>> {
+        static bool has(const details::Expected<T, E>& expected) {
+            return expected.has_value();
+        }
+
+        template <class TExpected>
+        static decltype(auto) get(TExpected&& expected) {
+            return *std::forward<TExpected>(expected);
+        }
+
+        template <class R>
+        using Rebind = details::Expected<std::decay_t<R>, E>;
+
+        template <class R, class TExpected>
+        static R fail(TExpected&& expected) {
+            return R(details::make_unexpected(std::forward<TExpected>(expected).error()));
+        }
+    };
+
+} /* namespace pipeline */
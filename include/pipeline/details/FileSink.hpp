@@ -0,0 +1,427 @@
+/**
+   \file
+
+   file_sink -- конечная стадия, которая пишет записи в файл
+   большими блоками:
+   \code
+   auto sink = file_sink("out.log");
+   if(!sink)
+       return sink.error();
+   *file | records() | filter(is_error) | *sink;
+   std::error_code error = flush_sink(*sink);
+   \endcode
+
+   Записи копируются в буфер, выровненный по странице. Заполненный
+   буфер передаётся потоку записи, а стадия продолжает писать в
+   следующий свободный буфер, поэтому вычисления идут одновременно
+   с вводом-выводом. Если поток записи отстал, то он забирает все
+   готовые буферы и пишет их одним writev.
+
+   Если свободных буферов нет, то стадия ждёт поток записи. Число
+   таких ожиданий и их время показывает sink_stats: это признак
+   того, что конвейер упирается в диск.
+
+   Стадия принимает std::string, std::string_view, Span<const char>
+   и другие типы с data() и size() из char, C-строки, а также
+   диапазоны и представления из них. Вызывать стадию можно только
+   из одного потока. Копии стадии пишут в один файл.
+
+   Ошибки записи запоминаются и возвращаются из flush_sink. После
+   ошибки данные больше не пишутся.
+
+   Только для POSIX систем.
+*/
+
+#pragma once
+
+#include <pipeline/details/CacheLine.hpp>
+#include <pipeline/details/Expected.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Range.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace pipeline {
+
+    namespace details {
+
+        struct FileSinkOptions {
+            /**
+               Размер одного буфера
+            */
+            std::size_t m_buffer_size = 1 << 20;
+            /**
+               Число буферов, не меньше двух
+            */
+            std::size_t m_buffers = 4;
+            /**
+               Дописывать в конец файла, а не перезаписывать его
+            */
+            bool m_append = false;
+            /**
+               Добавляется после каждой записи, например "\n"
+               для записей от records()
+            */
+            std::string m_separator;
+        };
+
+        struct FileSinkStats {
+            std::uint64_t m_records;
+            std::uint64_t m_bytes;
+            /**
+               Сколько буферов отдано потоку записи
+            */
+            std::uint64_t m_buffers;
+            /**
+               Сколько раз вызван writev
+            */
+            std::uint64_t m_writes;
+            /**
+               Сколько раз стадия ждала свободный буфер и
+               сколько всего длились ожидания
+            */
+            std::uint64_t m_waits;
+            std::uint64_t m_wait_nanoseconds;
+        };
+
+        /**
+           Владеет открытым файловым дескриптором
+        */
+        class FileDescriptor final {
+            int m_fd;
+        public:
+            explicit FileDescriptor(int fd)
+                : m_fd(fd) {}
+
+            FileDescriptor(FileDescriptor&& other)
+                : m_fd(other.m_fd) {
+                other.m_fd = -1;
+            }
+
+            FileDescriptor(const FileDescriptor&) = delete;
+            FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+            ~FileDescriptor() {
+                if(m_fd >= 0)
+                    ::close(m_fd);
+            }
+
+            int get() const {
+                return m_fd;
+            }
+        };
+
+        class FileSink final {
+            static constexpr std::size_t alignment = 4096;
+
+            struct Buffer {
+                // память от posix_memalign, освобождается через free
+                AlignedPtr<char> m_data;
+                std::size_t m_size;
+            };
+
+            // объявлены первыми: если конструктор не завершится,
+            // дескриптор и буферы освободятся сами
+            const FileDescriptor m_fd;
+            const std::size_t m_capacity;
+            const std::string m_separator;
+            std::vector<Buffer> m_buffers;
+
+            // поля стадии, их меняет только пишущий поток
+            std::size_t m_current;
+            FileSinkStats m_stats;
+
+            // общие поля под m_mutex
+            std::mutex m_mutex;
+            std::condition_variable m_ready;
+            std::condition_variable m_done;
+            std::deque<std::size_t> m_full;
+            std::vector<std::size_t> m_free;
+            bool m_writing;
+            bool m_stop;
+            std::error_code m_error;
+            std::uint64_t m_writes;
+
+            std::thread m_thread;
+
+            /**
+               Пишет все iov, продолжая после частичной записи
+            */
+            std::error_code writeAll(iovec* iov, int count, std::uint64_t& writes) {
+                while(count > 0) {
+                    const ssize_t written = writev(m_fd.get(), iov, count);
+                    ++writes;
+                    if(written < 0) {
+                        if(errno == EINTR)
+                            continue;
+                        return std::error_code(errno, std::generic_category());
+                    }
+
+                    std::size_t left = static_cast<std::size_t>(written);
+                    while(count > 0 && left >= iov->iov_len) {
+                        left -= iov->iov_len;
+                        ++iov;
+                        --count;
+                    }
+                    if(count > 0) {
+                        iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                        iov->iov_len -= left;
+                    }
+                }
+                return std::error_code();
+            }
+
+            void run() {
+                std::vector<std::size_t> batch;
+                std::vector<iovec> iov;
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                for(;;) {
+                    m_ready.wait(lock, [this] { return m_stop || !m_full.empty(); });
+                    if(m_full.empty())
+                        return;
+
+                    // все готовые буферы одним вызовом
+                    batch.clear();
+                    while(!m_full.empty() && batch.size() < IOV_MAX) {
+                        batch.push_back(m_full.front());
+                        m_full.pop_front();
+                    }
+                    m_writing = true;
+                    const bool failed = static_cast<bool>(m_error);
+                    lock.unlock();
+
+                    std::error_code error;
+                    std::uint64_t writes = 0;
+                    if(!failed) {
+                        iov.clear();
+                        for(std::size_t index : batch)
+                            iov.push_back(iovec{m_buffers[index].m_data.get(), m_buffers[index].m_size});
+                        error = writeAll(iov.data(), static_cast<int>(iov.size()), writes);
+                    }
+
+                    lock.lock();
+                    m_writes += writes;
+                    if(error && !m_error)
+                        m_error = error;
+                    for(std::size_t index : batch) {
+                        m_buffers[index].m_size = 0;
+                        m_free.push_back(index);
+                    }
+                    m_writing = false;
+                    m_done.notify_all();
+                }
+            }
+
+            /**
+               Отдаёт текущий буфер потоку записи и берёт
+               свободный, если нужно -- ждёт его
+            */
+            void submit() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_full.push_back(m_current);
+                ++m_stats.m_buffers;
+                m_ready.notify_one();
+
+                if(m_free.empty()) {
+                    const auto start = std::chrono::steady_clock::now();
+                    m_done.wait(lock, [this] { return !m_free.empty(); });
+                    ++m_stats.m_waits;
+                    m_stats.m_wait_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+                }
+                m_current = m_free.back();
+                m_free.pop_back();
+            }
+
+            void append(const char* data, std::size_t size) {
+                while(size != 0) {
+                    Buffer& buffer = m_buffers[m_current];
+                    const std::size_t chunk = std::min(size, m_capacity - buffer.m_size);
+                    std::memcpy(buffer.m_data.get() + buffer.m_size, data, chunk);
+                    buffer.m_size += chunk;
+                    data += chunk;
+                    size -= chunk;
+                    if(buffer.m_size == m_capacity)
+                        submit();
+                }
+            }
+        public:
+            FileSink(FileDescriptor&& fd, const FileSinkOptions& options)
+                : m_fd(std::move(fd)),
+                  m_capacity(std::max<std::size_t>(options.m_buffer_size, 1)),
+                  m_separator(options.m_separator),
+                  m_current(0),
+                  m_stats{0, 0, 0, 0, 0, 0},
+                  m_writing(false),
+                  m_stop(false),
+                  m_writes(0) {
+                const std::size_t count = std::max<std::size_t>(options.m_buffers, 2);
+                for(std::size_t i = 0; i < count; ++i) {
+                    void* data = nullptr;
+                    if(posix_memalign(&data, alignment, m_capacity) != 0) {
+#ifdef __cpp_exceptions
+                        throw std::bad_alloc();
+#else
+                        std::abort();
+#endif /* __cpp_exceptions */
+                    }
+                    m_buffers.push_back(Buffer{AlignedPtr<char>(static_cast<char*>(data)), 0});
+                    if(i != 0)
+                        m_free.push_back(i);
+                }
+                m_thread = std::thread([this] { run(); });
+            }
+
+            FileSink(const FileSink&) = delete;
+            FileSink& operator=(const FileSink&) = delete;
+
+            ~FileSink() {
+                flush();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                    m_ready.notify_one();
+                }
+                m_thread.join();
+            }
+
+            void write(const char* data, std::size_t size) {
+                ++m_stats.m_records;
+                m_stats.m_bytes += size + m_separator.size();
+                append(data, size);
+                append(m_separator.data(), m_separator.size());
+            }
+
+            /**
+               Отдаёт неполный буфер и ждёт пока все буферы
+               будут записаны
+
+               \return первая ошибка записи
+            */
+            std::error_code flush() {
+                if(m_buffers[m_current].m_size != 0)
+                    submit();
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this] { return m_full.empty() && !m_writing; });
+                return m_error;
+            }
+
+            /**
+               Вызывается из того же потока что и стадия
+            */
+            FileSinkStats stats() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                FileSinkStats stats = m_stats;
+                stats.m_writes = m_writes;
+                return stats;
+            }
+        };
+
+        template <class T, class = void>
+        struct IsBytes : std::false_type {};
+
+        template <class T>
+        struct IsBytes<T, std::enable_if_t<std::is_convertible<decltype(std::declval<const T&>().data()), const char*>::value &&
+                                           std::is_integral<decltype(std::declval<const T&>().size())>::value>>
+            : std::true_type {};
+
+        template <class T, class = void>
+        struct IsIterable : std::false_type {};
+
+        template <class T>
+        struct IsIterable<T, VoidT<decltype(std::begin(std::declval<T&>()))>> : std::true_type {};
+
+        /**
+           Функциональный объект стадии file_sink
+        */
+        class FileSinkStage final {
+            std::shared_ptr<FileSink> m_sink;
+
+            template <class Bytes>
+            void write(const Bytes& bytes, std::true_type /* bytes */) const {
+                m_sink->write(bytes.data(), bytes.size());
+            }
+
+            template <class Range>
+            void write(Range&& range, std::false_type /* bytes */) const {
+                pd::all(std::forward<Range>(range)).forEach([this](auto&& record) {
+                        (*this)(record);
+                        return true;
+                    });
+            }
+        public:
+            explicit FileSinkStage(std::shared_ptr<FileSink> sink)
+                : m_sink(std::move(sink)) {}
+
+            void operator()(const char* record) const {
+                m_sink->write(record, std::strlen(record));
+            }
+
+            template <class Record,
+                      class = std::enable_if_t<!std::is_convertible<Record, const char*>::value &&
+                                               (IsBytes<std::decay_t<Record>>::value ||
+                                                IsView<std::decay_t<Record>>::value ||
+                                                IsIterable<std::remove_reference_t<Record>>::value)>>
+            void operator()(Record&& record) const {
+                write(std::forward<Record>(record), IsBytes<std::decay_t<Record>>());
+            }
+
+            FileSink& sink() const {
+                return *m_sink;
+            }
+        };
+
+        /**
+           Открывает path и создаёт стадию для записи в него
+        */
+        inline Expected<PipeOp<FileSinkStage>, std::error_code>
+        file_sink(const std::string& path, const FileSinkOptions& options = FileSinkOptions()) {
+            const int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (options.m_append ? O_APPEND : O_TRUNC);
+            FileDescriptor fd(::open(path.c_str(), flags, 0644));
+            if(fd.get() < 0)
+                return make_unexpected(std::error_code(errno, std::generic_category()));
+
+            return PipeOp<FileSinkStage>(FileSinkStage(std::make_shared<FileSink>(std::move(fd), options)));
+        }
+
+        /**
+           Дописывает всё что накопила стадия file_sink
+
+           \return первая ошибка записи
+        */
+        inline std::error_code flush_sink(const PipeOp<FileSinkStage>& op) {
+            return op.m_func.sink().flush();
+        }
+
+        inline FileSinkStats sink_stats(const PipeOp<FileSinkStage>& op) {
+            return op.m_func.sink().stats();
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
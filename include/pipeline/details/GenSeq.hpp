@@ -5,27 +5,31 @@
 
    Для того чтобы получить последовательность до определённого
    числа используют вспомогательный класс GenSeq.
+
+   Последовательность строит std::make_integer_sequence. В GCC и
+   Clang он сделан через встроенные __integer_pack и
+   __make_integer_seq, поэтому не порождает N инстанцирований
+   как рекурсивное наследование.
 */
 
 #pragma once
 
+#include <utility>
+
 namespace pipeline {
 
     namespace details {
 
-        template <int...>
-        struct Seq {};
-
-        template <int N, int... S>
-        struct GenSeq : GenSeq<N-1, N-1, S...> {};
-
         template <int... S>
-        struct GenSeq<0, S...> {
-            using type = Seq<S...>;
+        using Seq = std::integer_sequence<int, S...>;
+
+        template <int N>
+        struct GenSeq {
+            using type = std::make_integer_sequence<int, N>;
         };
 
-        template <int... S>
-        using GenSeq_t = typename GenSeq<S...>::type;
+        template <int N>
+        using GenSeq_t = typename GenSeq<N>::type;
 
     } /* namespace details */
 
@@ -0,0 +1,142 @@
+/**
+   \file
+
+   Generator<T> -- источник для стадий диапазонов, написанный как
+   сопрограмма C++20:
+   \code
+   Generator<std::uint64_t> ids() {
+       for(std::uint64_t id = 0;; ++id)
+           co_yield id;
+   }
+
+   auto sample = ids() | filter(is_prime) | map(to_request) | take(1000) | to_vector;
+   \endcode
+
+   Generator -- это представление(см. Range.hpp), поэтому его можно
+   передать в map, filter, take, batch и другие стадии. Значения
+   вычисляются по одному, когда их запрашивает следующая стадия, и
+   в памяти хранится только последнее. Бесконечный генератор
+   останавливается стадией take: после этого сопрограмма просто
+   уничтожается вместе с Generator.
+
+   Generator однопроходный и только перемещается. Исключение из
+   сопрограммы бросается из forEach, то есть из той стадии, которая
+   материализует результат.
+
+   Значение co_yield копируется(или перемещается) в генератор, а
+   стадии получают ссылку на эту копию.
+
+   Только для C++20.
+*/
+
+#pragma once
+
+#include <pipeline/details/Range.hpp>
+#include <pipeline/details/Task.hpp>
+
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#ifdef __cpp_lib_coroutine
+
+namespace pipeline {
+
+    namespace details {
+
+        template <class T>
+        class Generator final : public RangeView {
+        public:
+            class promise_type {
+                std::optional<T> m_value;
+                std::exception_ptr m_error;
+            public:
+                Generator get_return_object() {
+                    return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+
+                std::suspend_always initial_suspend() noexcept {
+                    return {};
+                }
+
+                std::suspend_always final_suspend() noexcept {
+                    return {};
+                }
+
+                template <class U>
+                std::suspend_always yield_value(U&& value) {
+                    m_value.emplace(std::forward<U>(value));
+                    return {};
+                }
+
+                void return_void() {}
+
+                void unhandled_exception() {
+                    m_error = std::current_exception();
+                }
+
+                /**
+                   Запрещает co_await внутри генератора
+                */
+                template <class U>
+                void await_transform(U&&) = delete;
+
+                T& value() {
+                    return *m_value;
+                }
+
+                void rethrow() const {
+                    if(m_error)
+                        std::rethrow_exception(m_error);
+                }
+            };
+
+            using reference = T&;
+        private:
+            std::coroutine_handle<promise_type> m_handle;
+
+            explicit Generator(std::coroutine_handle<promise_type> handle)
+                : m_handle(handle) {}
+        public:
+            Generator(Generator&& other) noexcept
+                : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+            Generator& operator=(Generator&& other) noexcept {
+                if(this != &other) {
+                    if(m_handle)
+                        m_handle.destroy();
+                    m_handle = std::exchange(other.m_handle, nullptr);
+                }
+                return *this;
+            }
+
+            ~Generator() {
+                if(m_handle)
+                    m_handle.destroy();
+            }
+
+            /**
+               Передаёт значения в sink, пока генератор не
+               закончится или sink не вернёт false
+            */
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                while(m_handle && !m_handle.done()) {
+                    m_handle.resume();
+                    if(m_handle.done()) {
+                        m_handle.promise().rethrow();
+                        break;
+                    }
+                    if(!sink(m_handle.promise().value()))
+                        return false;
+                }
+                return true;
+            }
+        };
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_coroutine */
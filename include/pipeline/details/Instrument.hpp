@@ -0,0 +1,421 @@
+/**
+   \file
+
+   Инструментирование стадий: число вызовов, время и размеры
+   входа и выхода для каждой помеченной стадии:
+   \code
+   auto chain = instrument("parse", pipe_op(parse))
+       | instrument("enrich", pipe_op(enrich));
+   ...
+   for(const auto& stats : stage_stats())
+       std::cout << stats.m_label << ' ' << stats.m_calls << '\n';
+   \endcode
+
+   Инструментирование включается макросом PIPELINE_INSTRUMENTATION,
+   который должен быть одинаковым во всех единицах трансляции. Без
+   него instrument(label, op) возвращает сам op, поэтому код
+   получается таким же как без instrument.
+
+   Счётчики у каждого потока свои и пишутся без блокировок.
+   stage_stats() складывает счётчики всех потоков, в том числе уже
+   завершившихся.
+
+   Размер входа и выхода -- это size() значения, если такой метод
+   есть, и 1 иначе. Время измеряется по steady_clock, такты -- по
+   rdtsc там где он есть.
+
+   Между start_trace() и stop_trace() помеченные стадии ещё и
+   пишут события для Chrome trace, flush_trace(path) сохраняет их
+   в файл(см. Trace.hpp).
+*/
+
+#pragma once
+
+#include <pipeline/details/Ebo.hpp>
+#include <pipeline/details/JustReturn.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Суммарные счётчики одной стадии
+        */
+        struct StageStats {
+            std::string m_label;
+            std::uint64_t m_calls;
+            std::uint64_t m_nanoseconds;
+            std::uint64_t m_cycles;
+            std::uint64_t m_input_size;
+            std::uint64_t m_output_size;
+        };
+
+        /**
+           Реестр меток и счётчиков всех потоков
+        */
+        class Instrumentation final {
+        public:
+            /**
+               Счётчики стадии в одном потоке. Пишет только
+               поток-владелец, поэтому атомики нужны только для
+               чтения из stage_stats().
+            */
+            struct Counters {
+                std::atomic<std::uint64_t> m_calls{0};
+                std::atomic<std::uint64_t> m_nanoseconds{0};
+                std::atomic<std::uint64_t> m_cycles{0};
+                std::atomic<std::uint64_t> m_input_size{0};
+                std::atomic<std::uint64_t> m_output_size{0};
+            };
+
+            /**
+               Счётчики всех стадий одного потока
+            */
+            class ThreadTable final {
+                Instrumentation& m_owner;
+                std::mutex m_mutex;
+                std::vector<std::unique_ptr<Counters>> m_counters;
+
+                friend class Instrumentation;
+            public:
+                explicit ThreadTable(Instrumentation& owner)
+                    : m_owner(owner) {
+                    m_owner.attach(*this);
+                }
+
+                ThreadTable(const ThreadTable&) = delete;
+                ThreadTable& operator=(const ThreadTable&) = delete;
+
+                ~ThreadTable() {
+                    m_owner.detach(*this);
+                }
+
+                Counters& at(std::size_t id) {
+                    if(id >= m_counters.size()) {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        while(m_counters.size() <= id)
+                            m_counters.emplace_back(new Counters);
+                    }
+                    return *m_counters[id];
+                }
+            };
+        private:
+            std::mutex m_mutex;
+            std::vector<std::string> m_labels;
+            std::vector<ThreadTable*> m_tables;
+            std::vector<StageStats> m_retired;
+
+            static void add(StageStats& stats, const Counters& counters) {
+                stats.m_calls += counters.m_calls.load(std::memory_order_relaxed);
+                stats.m_nanoseconds += counters.m_nanoseconds.load(std::memory_order_relaxed);
+                stats.m_cycles += counters.m_cycles.load(std::memory_order_relaxed);
+                stats.m_input_size += counters.m_input_size.load(std::memory_order_relaxed);
+                stats.m_output_size += counters.m_output_size.load(std::memory_order_relaxed);
+            }
+
+            static void clear(Counters& counters) {
+                counters.m_calls.store(0, std::memory_order_relaxed);
+                counters.m_nanoseconds.store(0, std::memory_order_relaxed);
+                counters.m_cycles.store(0, std::memory_order_relaxed);
+                counters.m_input_size.store(0, std::memory_order_relaxed);
+                counters.m_output_size.store(0, std::memory_order_relaxed);
+            }
+
+            void attach(ThreadTable& table) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tables.push_back(&table);
+            }
+
+            /**
+               Счётчики завершившегося потока переносятся в m_retired
+            */
+            void detach(ThreadTable& table) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tables.erase(std::find(m_tables.begin(), m_tables.end(), &table));
+                for(std::size_t id = 0; id < table.m_counters.size(); ++id) {
+                    while(m_retired.size() <= id)
+                        m_retired.push_back(StageStats{m_labels[m_retired.size()], 0, 0, 0, 0, 0});
+                    add(m_retired[id], *table.m_counters[id]);
+                }
+            }
+        public:
+            static Instrumentation& instance() {
+                static Instrumentation instrumentation;
+                return instrumentation;
+            }
+
+            /**
+               Счётчики стадии id в текущем потоке
+            */
+            static Counters& local(std::size_t id) {
+                static thread_local ThreadTable table(instance());
+                return table.at(id);
+            }
+
+            /**
+               Номер стадии с меткой label. Стадии с одинаковыми
+               метками считаются вместе.
+            */
+            std::size_t id(const std::string& label) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const auto found = std::find(m_labels.begin(), m_labels.end(), label);
+                if(found != m_labels.end())
+                    return found - m_labels.begin();
+                m_labels.push_back(label);
+                return m_labels.size() - 1;
+            }
+
+            std::vector<std::string> labels() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_labels;
+            }
+
+            std::vector<StageStats> stats() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                std::vector<StageStats> result;
+                for(std::size_t id = 0; id < m_labels.size(); ++id)
+                    result.push_back(id < m_retired.size()
+                                     ? m_retired[id]
+                                     : StageStats{m_labels[id], 0, 0, 0, 0, 0});
+
+                for(ThreadTable* table : m_tables) {
+                    std::lock_guard<std::mutex> table_lock(table->m_mutex);
+                    for(std::size_t id = 0; id < table->m_counters.size(); ++id)
+                        add(result[id], *table->m_counters[id]);
+                }
+                return result;
+            }
+
+            /**
+               Обнуляет счётчики. Вызовы идущие в других потоках
+               в этот момент могут быть учтены частично.
+            */
+            void reset() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_retired.clear();
+                for(ThreadTable* table : m_tables) {
+                    std::lock_guard<std::mutex> table_lock(table->m_mutex);
+                    for(auto& counters : table->m_counters)
+                        clear(*counters);
+                }
+            }
+        };
+
+        /**
+           Размер значения для счётчиков входа и выхода
+        */
+        class StageSize {
+            template <class T>
+            static auto of(const T& value, int)
+                JUST_RETURN(
+                    static_cast<std::uint64_t>(value.size())
+                    );
+
+            template <class T>
+            static std::uint64_t of(const T&, long) {
+                return 1;
+            }
+        public:
+            template <class T>
+            static std::uint64_t of(const T& value) {
+                return of(value, 0);
+            }
+        };
+
+        /**
+           Замер одного вызова стадии. Записывает счётчики
+           при разрушении.
+        */
+        class StageScope final {
+            Instrumentation::Counters& m_counters;
+            const std::size_t m_id;
+            const bool m_traced;
+            std::uint64_t m_output_size;
+            std::chrono::steady_clock::time_point m_start;
+            std::uint64_t m_start_cycles;
+
+            static std::uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+                return __rdtsc();
+#else
+                return 0;
+#endif
+            }
+
+            static void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+                counter.store(counter.load(std::memory_order_relaxed) + value,
+                              std::memory_order_relaxed);
+            }
+        public:
+            StageScope(std::size_t id, std::uint64_t input_size)
+                : m_counters(Instrumentation::local(id)),
+                  m_id(id),
+                  m_traced(Trace::enabled()),
+                  m_output_size(0) {
+                add(m_counters.m_input_size, input_size);
+                if(m_traced)
+                    Trace::instance().record(m_id, 'B', input_size);
+                m_start = std::chrono::steady_clock::now();
+                m_start_cycles = cycles();
+            }
+
+            StageScope(const StageScope&) = delete;
+            StageScope& operator=(const StageScope&) = delete;
+
+            ~StageScope() {
+                const std::uint64_t end_cycles = cycles();
+                const auto elapsed = std::chrono::steady_clock::now() - m_start;
+
+                add(m_counters.m_calls, 1);
+                add(m_counters.m_nanoseconds,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                add(m_counters.m_cycles, end_cycles - m_start_cycles);
+                add(m_counters.m_output_size, m_output_size);
+                if(m_traced)
+                    Trace::instance().record(m_id, 'E', m_output_size);
+            }
+
+            template <class T>
+            void output(const T& value) {
+                m_output_size = StageSize::of(value);
+            }
+        };
+
+        /**
+           Вспомогательный класс для Instrumented. Вызывает
+           стадию внутри StageScope.
+        */
+        class InstrumentCall {
+            template <class Result, class Func, class Arg>
+            static Result call(std::size_t id, Func&& func, Arg&& arg, std::true_type /* void */) {
+                StageScope scope(id, StageSize::of(arg));
+                std::forward<Func>(func)(std::forward<Arg>(arg));
+            }
+
+            template <class Result, class Func, class Arg>
+            static Result call(std::size_t id, Func&& func, Arg&& arg, std::false_type /* void */) {
+                StageScope scope(id, StageSize::of(arg));
+                Result&& result = std::forward<Func>(func)(std::forward<Arg>(arg));
+                scope.output(result);
+                return std::forward<Result>(result);
+            }
+        public:
+            template <class Func, class Arg,
+                      class Result = decltype(std::declval<Func>()(std::declval<Arg>()))>
+            static Result call(std::size_t id, Func&& func, Arg&& arg) {
+                return call<Result>(id, std::forward<Func>(func), std::forward<Arg>(arg), std::is_void<Result>());
+            }
+        };
+
+        /**
+           Стадия Func с замером каждого вызова
+        */
+        template <class Func>
+        class Instrumented final : private Ebo<Func, Instrumented<Func>> {
+            using Storage = Ebo<Func, Instrumented<Func>>;
+
+            std::size_t m_id;
+        public:
+            Instrumented(Func func, std::size_t id)
+                : Storage(std::move(func)),
+                  m_id(id) {}
+
+            template <class TArg>
+            auto operator()(TArg&& arg) const &
+                JUST_RETURN(
+                    InstrumentCall::call(m_id, this->get(), std::forward<TArg>(arg))
+                    );
+
+            template <class TArg>
+            auto operator()(TArg&& arg) &
+                JUST_RETURN(
+                    InstrumentCall::call(m_id, this->get(), std::forward<TArg>(arg))
+                    );
+
+            template <class TArg>
+            auto operator()(TArg&& arg) &&
+                JUST_RETURN(
+                    InstrumentCall::call(m_id, std::move(*this).Storage::get(), std::forward<TArg>(arg))
+                    );
+        };
+
+        /**
+           Оборачивает op в замер независимо от
+           PIPELINE_INSTRUMENTATION
+        */
+        template <class Func>
+        auto instrumented(const char* label, PipeOp<Func> op) {
+            const std::size_t id = Instrumentation::instance().id(label);
+            return PipeOp<Instrumented<Func>>(Instrumented<Func>(std::move(op.m_func), id));
+        }
+
+        /**
+           Помечает стадию op меткой label. Без
+           PIPELINE_INSTRUMENTATION возвращает op.
+        */
+        template <class Func>
+        auto instrument(const char* label, PipeOp<Func> op) {
+#ifdef PIPELINE_INSTRUMENTATION
+            return pd::instrumented(label, std::move(op));
+#else
+            (void)label;
+            return op;
+#endif /* PIPELINE_INSTRUMENTATION */
+        }
+
+        /**
+           Счётчики всех помеченных стадий по всем потокам
+        */
+        inline std::vector<StageStats> stage_stats() {
+            return Instrumentation::instance().stats();
+        }
+
+        inline void reset_stage_stats() {
+            Instrumentation::instance().reset();
+        }
+
+        /**
+           Включает запись событий для Chrome trace
+        */
+        inline void start_trace() {
+            Trace::instance().start();
+        }
+
+        inline void stop_trace() {
+            Trace::instance().stop();
+        }
+
+        /**
+           Сохраняет в path события записанные с прошлого
+           flush_trace. Файл открывается в chrome://tracing или
+           ui.perfetto.dev.
+
+           \return false если файл не удалось записать
+        */
+        inline bool flush_trace(const std::string& path) {
+            return Trace::instance().flush(path, Instrumentation::instance().labels());
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,169 @@
+/**
+   \file
+
+   MappedFile -- файл отображённый в память только для чтения.
+
+   Файл не читается в буфер: страницы подгружает ядро когда к
+   ним обращаются, а подсказка MADV_SEQUENTIAL включает упреждающее
+   чтение и позволяет быстро выбрасывать уже прочитанные страницы.
+   Поэтому многогигабайтные логи обрабатываются без копирования и
+   без выделения памяти под каждую строку(см. Records.hpp).
+
+   Ошибки возвращаются через Expected<MappedFile, std::error_code>:
+   \code
+   auto file = map_file("access.log");
+   if(!file)
+       return file.error();
+   auto errors = *file | records('\n') | filter(is_error) | to_vector;
+   \endcode
+
+   Записи -- это std::string_view внутри отображения, поэтому
+   MappedFile должен жить пока они используются.
+
+   Только для POSIX систем и C++17.
+*/
+
+#pragma once
+
+#include <pipeline/details/Expected.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __cpp_lib_string_view
+
+namespace pipeline {
+
+    namespace details {
+
+        class MappedFile final {
+            const char* m_data;
+            std::size_t m_size;
+
+            MappedFile(const char* data, std::size_t size)
+                : m_data(data),
+                  m_size(size) {}
+
+            static std::error_code lastError() {
+                return std::error_code(errno, std::generic_category());
+            }
+        public:
+            MappedFile()
+                : m_data(nullptr),
+                  m_size(0) {}
+
+            MappedFile(MappedFile&& other) noexcept
+                : m_data(std::exchange(other.m_data, nullptr)),
+                  m_size(std::exchange(other.m_size, 0)) {}
+
+            MappedFile& operator=(MappedFile&& other) noexcept {
+                if(this != &other) {
+                    close();
+                    m_data = std::exchange(other.m_data, nullptr);
+                    m_size = std::exchange(other.m_size, 0);
+                }
+                return *this;
+            }
+
+            ~MappedFile() {
+                close();
+            }
+
+            /**
+               Отображает файл path целиком
+            */
+            static Expected<MappedFile, std::error_code> open(const std::string& path) {
+                const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if(fd < 0)
+                    return make_unexpected(lastError());
+
+                struct stat info;
+                if(fstat(fd, &info) != 0) {
+                    const std::error_code error = lastError();
+                    ::close(fd);
+                    return make_unexpected(error);
+                }
+
+                const std::size_t size = static_cast<std::size_t>(info.st_size);
+                if(size == 0) {
+                    // mmap не отображает пустые файлы
+                    ::close(fd);
+                    return MappedFile();
+                }
+
+                void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                const std::error_code error = lastError();
+                // отображение остаётся и после закрытия файла
+                ::close(fd);
+                if(data == MAP_FAILED)
+                    return make_unexpected(error);
+
+                madvise(data, size, MADV_SEQUENTIAL);
+                return MappedFile(static_cast<const char*>(data), size);
+            }
+
+            void close() {
+                if(m_data)
+                    munmap(const_cast<char*>(m_data), m_size);
+                m_data = nullptr;
+                m_size = 0;
+            }
+
+            const char* data() const {
+                return m_data;
+            }
+
+            std::size_t size() const {
+                return m_size;
+            }
+
+            bool empty() const {
+                return m_size == 0;
+            }
+
+            std::string_view view() const {
+                return std::string_view(m_data, m_size);
+            }
+        };
+
+        /**
+           Отображает файл path в память
+        */
+        inline Expected<MappedFile, std::error_code> map_file(const std::string& path) {
+            return MappedFile::open(path);
+        }
+
+        /**
+           Отображает файлы paths в память. Останавливается на
+           первой ошибке.
+        */
+        inline Expected<std::vector<MappedFile>, std::error_code> map_files(const std::vector<std::string>& paths) {
+            std::vector<MappedFile> files;
+            files.reserve(paths.size());
+            for(const auto& path : paths) {
+                auto file = MappedFile::open(path);
+                if(!file)
+                    return make_unexpected(std::move(file).error());
+                files.push_back(std::move(*file));
+            }
+            return Expected<std::vector<MappedFile>, std::error_code>(std::move(files));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_string_view */
@@ -0,0 +1,310 @@
+/**
+   \file
+
+   Канал Maybe: значения которые могут отсутствовать(std::optional,
+   указатели, умные указатели) проходят по pipeline без ручных
+   проверок. Указатели на символы(const char* и т.п.) считаются
+   строками и в канал не входят:
+   \code
+   std::optional<Record> find(int id);
+
+   auto name = id | pipe_op(find) | pipe_op(&Record::name);
+   // name -- std::optional<std::string>
+   \endcode
+
+   Если стадия не принимает Maybe, но принимает значение внутри
+   него, то стадия вызывается только если значение есть. Иначе
+   результатом будет пустой Maybe, а стадия пропускается.
+
+   В композиции op1 | op2 | op3 остаток цепочки хранится как один
+   объект(см. Composed.hpp), поэтому пустое значение делает одну
+   проверку и сразу выходит в конец цепочки, а не проверяется
+   перед каждой оставшейся стадией.
+
+   Тип результата стадии R:
+   - void -- стадия просто не вызывается;
+   - Maybe -- он и возвращается, пустой если значения не было.
+     После указателя или std::optional пустой R создаётся
+     конструктором по умолчанию, поэтому Expected(у которого
+     без ошибки нет пустого состояния) там не подходит: это
+     ошибка компиляции с понятным сообщением;
+   - любой другой -- заворачивается в MaybeTraits<M>::Rebind<R>.
+
+   Исключения не используются, поэтому канал работает и с
+   -fno-exceptions.
+*/
+
+#pragma once
+
+#include <pipeline/details/JustReturn.hpp>
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 201703L
+#include <optional>
+#endif
+
+namespace pipeline {
+
+    /**
+       Точка настройки канала Maybe. Лежит в namespace pipeline,
+       чтобы её можно было специализировать для своих типов, как
+       это сделано в examples/maybe.cpp для boost::optional.
+
+       Специализация должна содержать:
+       - static bool has(const M&) -- есть ли значение;
+       - static ... get(TM&& m) -- значение внутри m, с сохранением
+         категории m;
+       - template <class R> using Rebind -- тип в который
+         заворачивается результат R обычной стадии;
+       - template <class R, class TM> static R fail(TM&& m) --
+         пустой R для пустого m.
+    */
+    template <class T, class = void>
+    struct MaybeTraits {};
+
+    namespace details {
+
+        template <class...>
+        struct MakeVoid {
+            using type = void;
+        };
+
+        template <class... T>
+        using VoidT = typename MakeVoid<T...>::type;
+
+        template <class T, class = void>
+        struct IsMaybe : std::false_type {};
+
+        template <class T>
+        struct IsMaybe<T, VoidT<decltype(MaybeTraits<T>::has(std::declval<const T&>()))>>
+            : std::true_type {};
+
+        template <class Func, class Arg, class = void>
+        struct IsCallable : std::false_type {};
+
+        template <class Func, class Arg>
+        struct IsCallable<Func, Arg, VoidT<decltype(std::declval<Func>()(std::declval<Arg>()))>>
+            : std::true_type {};
+
+        /**
+           Результат Rebind для указателей: ссылка превращается
+           в указатель, значение -- в std::optional. Без
+           std::optional стадия возвращающая значение не
+           подходит: указатель на временный результат повис бы.
+        */
+        template <class R, bool = std::is_lvalue_reference<R>::value>
+        struct PointerRebind {};
+
+        template <class R>
+        struct PointerRebind<R, true> {
+            using type = std::remove_reference_t<R>*;
+        };
+
+#ifdef __cpp_lib_optional
+        template <class R>
+        struct PointerRebind<R, false> {
+            using type = std::optional<std::decay_t<R>>;
+        };
+#endif /* __cpp_lib_optional */
+
+        /**
+           Символьные типы. Указатель на них -- это строка, а не
+           Maybe: "abc" | pipe_op(f) не должен разыменовываться и
+           проверяться на nullptr.
+        */
+        template <class T>
+        struct IsCharacter : std::false_type {};
+
+        template <> struct IsCharacter<char> : std::true_type {};
+        template <> struct IsCharacter<signed char> : std::true_type {};
+        template <> struct IsCharacter<unsigned char> : std::true_type {};
+        template <> struct IsCharacter<wchar_t> : std::true_type {};
+        template <> struct IsCharacter<char16_t> : std::true_type {};
+        template <> struct IsCharacter<char32_t> : std::true_type {};
+#ifdef __cpp_char8_t
+        template <> struct IsCharacter<char8_t> : std::true_type {};
+#endif /* __cpp_char8_t */
+
+        /**
+           Общая часть MaybeTraits для указателей и
+           умных указателей
+        */
+        template <class Pointer>
+        struct PointerMaybeTraits {
+            static bool has(const Pointer& pointer) {
+                return static_cast<bool>(pointer);
+            }
+
+            template <class TPointer>
+            static auto& get(TPointer&& pointer) {
+                return *pointer;
+            }
+
+            template <class R>
+            using Rebind = typename PointerRebind<R>::type;
+
+            template <class R, class TPointer>
+            static R fail(TPointer&&) {
+                static_assert(std::is_default_constructible<R>::value,
+                              "A stage after a pointer must return a default-constructible Maybe: "
+                              "an empty pointer has no error to put into Expected");
+                return R();
+            }
+        };
+
+    } /* namespace details */
+
+    template <class T>
+    struct MaybeTraits<T*, std::enable_if_t<std::is_object<T>::value &&
+                                            !details::IsCharacter<std::remove_cv_t<T>>::value>>
+        : details::PointerMaybeTraits<T*> {};
+
+    template <class T, class Deleter>
+    struct MaybeTraits<std::unique_ptr<T, Deleter>>
+        : details::PointerMaybeTraits<std::unique_ptr<T, Deleter>> {};
+
+    template <class T>
+    struct MaybeTraits<std::shared_ptr<T>>
+        : details::PointerMaybeTraits<std::shared_ptr<T>> {};
+
+#ifdef __cpp_lib_optional
+    template <class T>
+    struct MaybeTraits<std::optional<T>> {
+        static bool has(const std::optional<T>& maybe) {
+            return maybe.has_value();
+        }
+
+        template <class TMaybe>
+        static decltype(auto) get(TMaybe&& maybe) {
+            return *std::forward<TMaybe>(maybe);
+        }
+
+        template <class R>
+        using Rebind = std::optional<std::decay_t<R>>;
+
+        template <class R, class TMaybe>
+        static R fail(TMaybe&&) {
+            static_assert(std::is_default_constructible<R>::value,
+                          "A stage after std::optional must return a default-constructible Maybe: "
+                          "an empty optional has no error to put into Expected");
+            return R();
+        }
+    };
+#endif /* __cpp_lib_optional */
+
+    namespace details {
+
+        template <class Maybe>
+        using MaybeValue = decltype(MaybeTraits<std::decay_t<Maybe>>::get(std::declval<Maybe>()));
+
+        template <class Func, class Maybe>
+        using MaybeStageResult = decltype(std::declval<Func>()(std::declval<MaybeValue<Maybe>>()));
+
+        /**
+           Теги для вида результата стадии
+        */
+        struct MaybeSkip {};
+        struct MaybeJoin {};
+        struct MaybeWrap {};
+
+        template <class R,
+                  bool = std::is_void<R>::value,
+                  bool = IsMaybe<std::decay_t<R>>::value>
+        struct MaybeKind {
+            using type = MaybeWrap;
+        };
+
+        template <class R, bool IsMaybeResult>
+        struct MaybeKind<R, true, IsMaybeResult> {
+            using type = MaybeSkip;
+        };
+
+        template <class R>
+        struct MaybeKind<R, false, true> {
+            using type = MaybeJoin;
+        };
+
+        template <class Func, class Maybe>
+        using MaybeKindOf = typename MaybeKind<MaybeStageResult<Func, Maybe>>::type;
+
+        /**
+           Вызов стадии со значением из Maybe
+        */
+        class MaybeCall {
+            template <class Target, class R>
+            static Target wrap(R&& result, std::true_type /* pointer */) {
+                return &result;
+            }
+
+            template <class Target, class R>
+            static Target wrap(R&& result, std::false_type /* pointer */) {
+                return Target(std::forward<R>(result));
+            }
+        public:
+            template <class Func, class Maybe>
+            static void call(Func&& func, Maybe&& maybe, MaybeSkip) {
+                using Traits = MaybeTraits<std::decay_t<Maybe>>;
+                if(Traits::has(maybe))
+                    std::forward<Func>(func)(Traits::get(std::forward<Maybe>(maybe)));
+            }
+
+            template <class Func, class Maybe,
+                      class Result = std::decay_t<MaybeStageResult<Func, Maybe>>>
+            static Result call(Func&& func, Maybe&& maybe, MaybeJoin) {
+                using Traits = MaybeTraits<std::decay_t<Maybe>>;
+                if(Traits::has(maybe))
+                    return std::forward<Func>(func)(Traits::get(std::forward<Maybe>(maybe)));
+                return Traits::template fail<Result>(std::forward<Maybe>(maybe));
+            }
+
+            template <class Func, class Maybe,
+                      class Result = typename MaybeTraits<std::decay_t<Maybe>>::template Rebind<MaybeStageResult<Func, Maybe>>>
+            static Result call(Func&& func, Maybe&& maybe, MaybeWrap) {
+                using Traits = MaybeTraits<std::decay_t<Maybe>>;
+                if(Traits::has(maybe))
+                    return wrap<Result>(std::forward<Func>(func)(Traits::get(std::forward<Maybe>(maybe))),
+                                        std::is_pointer<Result>());
+                return Traits::template fail<Result>(std::forward<Maybe>(maybe));
+            }
+        };
+
+        /**
+           Вспомогательный класс для pipe_call. Выбирает
+           прямой вызов или вызов через канал Maybe.
+        */
+        class PipeCall {
+        public:
+            template <class Func, class Arg>
+            static auto call(Func&& func, Arg&& arg, std::true_type /* callable */)
+                JUST_RETURN(
+                    std::forward<Func>(func)(std::forward<Arg>(arg))
+                    );
+
+            template <class Func, class Arg>
+            static auto call(Func&& func, Arg&& arg, std::false_type /* callable */)
+                JUST_RETURN(
+                    MaybeCall::call(std::forward<Func>(func),
+                                    std::forward<Arg>(arg),
+                                    MaybeKindOf<Func, Arg>())
+                    );
+        };
+
+        /**
+           Передаёт arg в стадию func так же как это делает
+           operator|: напрямую, если func принимает arg, или
+           через канал Maybe.
+        */
+        template <class Func, class Arg>
+        auto pipe_call(Func&& func, Arg&& arg)
+            JUST_RETURN(
+                PipeCall::call(std::forward<Func>(func),
+                               std::forward<Arg>(arg),
+                               IsCallable<Func, Arg>())
+                );
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,281 @@
+/**
+   \file
+
+   Параллельные стадии работающие поверх ThreadPool.
+
+   par_map применяет функцию к каждому элементу диапазона с
+   произвольным доступом(std::vector, std::array, массив) в
+   нескольких потоках:
+   \code
+   auto hashes = records | par_map(&Record::hash);
+   \endcode
+
+   Диапазон режется на куски по chunk элементов, куски
+   распределяются по очередям пула. Каждый результат пишется
+   в ячейку со своим индексом, поэтому порядок результатов
+   совпадает с порядком элементов независимо от того, какой
+   поток что посчитал.
+
+   par_fold сворачивает такой диапазон в одно значение:
+   \code
+   double total = prices | par_fold(0.0, std::plus<>(), std::plus<>());
+   \endcode
+
+   Каждый кусок сворачивается функцией fold в своё значение,
+   начиная с init. Затем оно добавляется функцией combine в
+   аккумулятор потока, который выполнял кусок. Аккумуляторы
+   выровнены по кэш-линии, поэтому потоки не мешают друг другу.
+   В конце аккумуляторы объединяются тем же combine. init
+   должен быть нейтральным для combine(0 для суммы, пустая
+   гистограмма и т.п.), так как используется много раз.
+
+   Порядок объединения аккумуляторов зависит от того, какие
+   куски достались каким потокам. Для чисел с плавающей точкой
+   это значит, что результат может меняться от запуска к
+   запуску. С FoldOrder::ordered значение каждого куска
+   сохраняется отдельно, и они объединяются по порядку кусков:
+   при одинаковом chunk результат всегда одинаковый.
+*/
+
+#pragma once
+
+#include <pipeline/details/CacheLine.hpp>
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/ThreadPool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Функциональный объект стадии par_map.
+
+           Func вызывается одновременно из нескольких потоков
+           через const ссылку. Тип результата Func должен иметь
+           конструктор по умолчанию.
+        */
+        template <class Func>
+        class ParMapStage final {
+            Func m_func;
+            ThreadPool* m_pool;
+            std::size_t m_chunk;
+        public:
+            ParMapStage(Func func, ThreadPool& pool, std::size_t chunk)
+                : m_func(std::move(func)),
+                  m_pool(&pool),
+                  m_chunk(chunk) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const {
+                auto first = std::begin(range);
+                const std::size_t size = std::end(range) - first;
+
+                using Result = std::decay_t<decltype(m_func(first[0]))>;
+                static_assert(!std::is_same<Result, bool>::value,
+                              "par_map can't write std::vector<bool> from several threads");
+
+                std::vector<Result> result(size);
+
+                auto body = [this, &first, &result](std::size_t begin, std::size_t end) {
+                    for(std::size_t i = begin; i < end; ++i)
+                        result[i] = m_func(first[i]);
+                };
+                m_pool->parallelFor(size, m_chunk, body);
+
+                return result;
+            }
+        };
+
+        /**
+           Стадия применяющая func к каждому элементу в пуле pool.
+
+           \param chunk число элементов в одной задаче. Если 0, то
+           выбирается автоматически
+        */
+        template <class Func>
+        auto par_map(ThreadPool& pool, Func&& func, std::size_t chunk = 0) {
+            auto callable = pd::function(std::forward<Func>(func));
+            using Stage = ParMapStage<decltype(callable)>;
+            return PipeOp<Stage>(Stage(std::move(callable), pool, chunk));
+        }
+
+        /**
+           Стадия применяющая func к каждому элементу в пуле
+           по умолчанию
+        */
+        template <class Func>
+        auto par_map(Func&& func, std::size_t chunk = 0) {
+            return pd::par_map(ThreadPool::instance(), std::forward<Func>(func), chunk);
+        }
+
+        /**
+           Порядок объединения результатов кусков в par_fold
+        */
+        enum class FoldOrder {
+            /**
+               В аккумуляторах потоков, порядок не определён
+            */
+            any,
+
+            /**
+               По порядку кусков, результат не зависит от потоков
+            */
+            ordered
+        };
+
+        /**
+           Функциональный объект стадии par_fold.
+
+           Fold и Combine вызываются одновременно из нескольких
+           потоков через const ссылку.
+        */
+        template <class Acc, class Fold, class Combine>
+        class ParFoldStage final {
+            /**
+               Аккумулятор одного потока
+            */
+            struct alignas(cache_line_size) Slot {
+                Acc m_value;
+                bool m_used;
+
+                explicit Slot(const Acc& init)
+                    : m_value(init),
+                      m_used(false) {}
+            };
+
+            Acc m_init;
+            Fold m_fold;
+            Combine m_combine;
+            ThreadPool* m_pool;
+            FoldOrder m_order;
+            std::size_t m_chunk;
+
+            template <class Iterator>
+            Acc foldChunk(Iterator first, std::size_t begin, std::size_t end) const {
+                Acc acc = m_init;
+                for(std::size_t i = begin; i < end; ++i)
+                    acc = m_fold(std::move(acc), first[i]);
+                return acc;
+            }
+
+            void merge(Slot& slot, Acc acc) const {
+                slot.m_value = slot.m_used ? m_combine(std::move(slot.m_value), std::move(acc)) : std::move(acc);
+                slot.m_used = true;
+            }
+
+            template <class Iterator>
+            Acc foldAny(Iterator first, std::size_t size) const {
+                // последний аккумулятор для потоков не из пула, например
+                // вызывающего: их может быть несколько, поэтому с мьютексом
+                const std::size_t workers = m_pool->size();
+                std::vector<AlignedPtr<Slot>> slots;
+                for(std::size_t i = 0; i <= workers; ++i)
+                    slots.push_back(make_aligned<Slot>(m_init));
+                std::mutex outside_mutex;
+
+                auto body = [&](std::size_t begin, std::size_t end) {
+                    Acc acc = foldChunk(first, begin, end);
+                    const std::size_t worker = m_pool->currentWorker();
+                    if(worker != ThreadPool::no_worker) {
+                        merge(*slots[worker], std::move(acc));
+                    } else {
+                        std::lock_guard<std::mutex> lock(outside_mutex);
+                        merge(*slots[workers], std::move(acc));
+                    }
+                };
+                m_pool->parallelFor(size, m_chunk, body);
+
+                Acc result = m_init;
+                bool used = false;
+                for(auto& slot : slots) {
+                    if(!slot->m_used)
+                        continue;
+                    result = used ? m_combine(std::move(result), std::move(slot->m_value)) : std::move(slot->m_value);
+                    used = true;
+                }
+                return result;
+            }
+
+            template <class Iterator>
+            Acc foldOrdered(Iterator first, std::size_t size) const {
+                const std::size_t chunk = m_chunk != 0 ? m_chunk : std::max<std::size_t>(size / (m_pool->size() * 4), 1);
+                const std::size_t count = (size + chunk - 1) / chunk;
+
+                // каждый кусок пишет свою ячейку один раз, выравнивание не нужно
+                std::vector<Acc> chunks(count, m_init);
+
+                auto body = [&](std::size_t begin, std::size_t end) {
+                    chunks[begin / chunk] = foldChunk(first, begin, end);
+                };
+                m_pool->parallelFor(size, chunk, body);
+
+                Acc result = std::move(chunks.front());
+                for(std::size_t i = 1; i < count; ++i)
+                    result = m_combine(std::move(result), std::move(chunks[i]));
+                return result;
+            }
+        public:
+            ParFoldStage(Acc init, Fold fold, Combine combine, ThreadPool& pool, FoldOrder order, std::size_t chunk)
+                : m_init(std::move(init)),
+                  m_fold(std::move(fold)),
+                  m_combine(std::move(combine)),
+                  m_pool(&pool),
+                  m_order(order),
+                  m_chunk(chunk) {}
+
+            template <class Range>
+            Acc operator()(Range&& range) const {
+                auto first = std::begin(range);
+                const std::size_t size = std::end(range) - first;
+
+                if(size == 0)
+                    return m_init;
+                if(m_order == FoldOrder::ordered)
+                    return foldOrdered(first, size);
+                return foldAny(first, size);
+            }
+        };
+
+        /**
+           Стадия сворачивающая диапазон в пуле pool:
+           fold(acc, x) добавляет элемент к значению, а
+           combine(a, b) объединяет два значения.
+
+           \param init начальное значение, нейтральное для combine
+           \param order порядок объединения результатов кусков
+           \param chunk число элементов в одной задаче. Если 0, то
+           выбирается автоматически
+        */
+        template <class Acc, class Fold, class Combine>
+        auto par_fold(ThreadPool& pool, Acc init, Fold&& fold, Combine&& combine,
+                      FoldOrder order = FoldOrder::any, std::size_t chunk = 0) {
+            auto fold_callable = pd::function(std::forward<Fold>(fold));
+            auto combine_callable = pd::function(std::forward<Combine>(combine));
+            using Stage = ParFoldStage<Acc, decltype(fold_callable), decltype(combine_callable)>;
+            return PipeOp<Stage>(Stage(std::move(init), std::move(fold_callable), std::move(combine_callable),
+                                       pool, order, chunk));
+        }
+
+        /**
+           Стадия сворачивающая диапазон в пуле по умолчанию
+        */
+        template <class Acc, class Fold, class Combine>
+        auto par_fold(Acc init, Fold&& fold, Combine&& combine,
+                      FoldOrder order = FoldOrder::any, std::size_t chunk = 0) {
+            return pd::par_fold(ThreadPool::instance(), std::move(init), std::forward<Fold>(fold),
+                                std::forward<Combine>(combine), order, chunk);
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Composed.hpp>
 #include <pipeline/details/JustReturn.hpp>
+#include <pipeline/details/Maybe.hpp>
 #include <pipeline/details/Namespaces.hpp>
 
+#include <type_traits>
+
 namespace pipeline {
 
     namespace details {
@@ -19,22 +23,39 @@ namespace pipeline {
         struct PipeOp final {
             Func m_func;
 
-            explicit PipeOp(Func func)
+            explicit constexpr PipeOp(Func func)
                 : m_func(std::move(func)) {}
 
             template <class TArg>
-            auto operator()(TArg&& arg) const
+            auto operator()(TArg&& arg) const &
                 JUST_RETURN(
                     m_func(std::forward<TArg>(arg))
                     );
 
             template <class TArg>
-            auto operator()(TArg&& arg)
+            auto operator()(TArg&& arg) &
                 JUST_RETURN(
                     m_func(std::forward<TArg>(arg))
                     );
+
+            /**
+               Вызов временного PipeOp. m_func вызывается как
+               rvalue, поэтому привязанные аргументы перемещаются,
+               а не копируются.
+            */
+            template <class TArg>
+            auto operator()(TArg&& arg) &&
+                JUST_RETURN(
+                    std::move(m_func)(std::forward<TArg>(arg))
+                    );
         };
 
+        template <class T>
+        struct IsPipeOp : std::false_type {};
+
+        template <class Func>
+        struct IsPipeOp<PipeOp<Func>> : std::true_type {};
+
         /**
            Эта фукнция создаёт PipeOp из переданной функции,
            функционального объекта(класса или лямбды) или метода.
@@ -47,6 +68,27 @@ namespace pipeline {
             return PipeOp<decltype(callable)>(std::move(callable));
         }
 
+        /**
+           Эта фукнция создаёт PipeOp из функции или метода
+           известного на этапе компиляции: pipe_op<decltype(&f), &f>().
+
+           Такой PipeOp пустой и всегда вызывает функцию напрямую.
+        */
+        template <class Ptr, Ptr ptr>
+        auto pipe_op() {
+            return PipeOp<StaticCallable<Ptr, ptr>>(pd::function<Ptr, ptr>());
+        }
+
+#ifdef __cpp_nontype_template_parameter_auto
+        /**
+           Краткая запись для C++17: pipe_op<&f>()
+        */
+        template <auto ptr>
+        auto pipe_op() {
+            return pd::pipe_op<decltype(ptr), ptr>();
+        }
+#endif /* __cpp_nontype_template_parameter_auto */
+
         /**
            Этот пайп используется для передачи объекта
            в не константный PipeOp.
@@ -54,11 +96,16 @@ namespace pipeline {
            Передаваемый объект может быть константным,
            это корректно обработается так как T -- универсальная
            ссылка.
+
+           Если op не принимает t, а t -- это Maybe(std::optional,
+           указатель и т.п.), то op получает значение внутри t и
+           вызывается только если оно есть(см. Maybe.hpp).
         */
-        template <class T, class Callable>
+        template <class T, class Callable,
+                  class = std::enable_if_t<!IsPipeOp<std::decay_t<T>>::value>>
         auto operator|(T&& t, PipeOp<Callable>& op)
             JUST_RETURN(
-                op(std::forward<T>(t))
+                pd::pipe_call(op, std::forward<T>(t))
                 );
 
         /**
@@ -73,10 +120,11 @@ namespace pipeline {
            как он сам не передаётся по универсальной ссылке
            так как сам PipeOp не шаблонный параметр.
         */
-        template <class T, class Callable>
+        template <class T, class Callable,
+                  class = std::enable_if_t<!IsPipeOp<std::decay_t<T>>::value>>
         auto operator|(T&& t, const PipeOp<Callable>& op)
             JUST_RETURN(
-                op(std::forward<T>(t))
+                pd::pipe_call(op, std::forward<T>(t))
                 );
 
         /**
@@ -86,13 +134,34 @@ namespace pipeline {
            Передаваемый объект может быть константным,
            это корректно обработается так как T -- универсальная
            ссылка.
+
+           Временный PipeOp больше не нужен, поэтому он
+           вызывается как rvalue и может отдать свои данные.
         */
-        template <class T, class Callable>
+        template <class T, class Callable,
+                  class = std::enable_if_t<!IsPipeOp<std::decay_t<T>>::value>>
         auto operator|(T&& t, PipeOp<Callable>&& op)
             JUST_RETURN(
-                op(std::forward<T>(t))
+                pd::pipe_call(std::move(op), std::forward<T>(t))
                 );
 
+        /**
+           Этот пайп соединяет два PipeOp в один без
+           передачи значения: op1 | op2 | op3.
+
+           Результатом является PipeOp<Composed<...>>, который
+           можно сохранить и вызывать много раз. Вызов такого
+           PipeOp эквивалентен op3(op2(op1(x))).
+        */
+        template <class Left, class Right,
+                  class = std::enable_if_t<IsPipeOp<std::decay_t<Left>>::value &&
+                                           IsPipeOp<std::decay_t<Right>>::value>>
+        auto operator|(Left&& left, Right&& right) {
+            auto composed = pd::compose(std::forward<Left>(left).m_func,
+                                        std::forward<Right>(right).m_func);
+            return PipeOp<decltype(composed)>(std::move(composed));
+        }
+
     } /* namespace details */
 
 } /* namespace pipeline */
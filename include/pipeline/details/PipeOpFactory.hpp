@@ -47,15 +47,19 @@ namespace pipeline {
             }
 
             template <class... TArgs>
-            auto operator()(TArgs&&... args) const {
+            auto operator()(TArgs&&... args) const & {
                 // вместо std::bind используется bind как легковесная
                 // альтернатива
                 return pipe_op(pd::bind(m_func, std::forward<TArgs>(args)...));
             }
 
+            /**
+               Временная фабрика перемещает функцию в PipeOp:
+               1 | f << args(2) не копирует f
+            */
             template <class... TArgs>
-            auto operator()(TArgs&&... args) {
-                return pipe_op(pd::bind(m_func, std::forward<TArgs>(args)...));
+            auto operator()(TArgs&&... args) && {
+                return pipe_op(pd::bind(std::move(m_func), std::forward<TArgs>(args)...));
             }
         };
 
@@ -69,6 +73,25 @@ namespace pipeline {
             return PipeOpFactory<decltype(callable)>(std::move(callable));
         }
 
+        /**
+           Эта фукнция создаёт PipeOpFactory из функции или метода
+           известного на этапе компиляции: pipe_op_factory<decltype(&f), &f>().
+        */
+        template <class Ptr, Ptr ptr>
+        auto pipe_op_factory() {
+            return PipeOpFactory<StaticCallable<Ptr, ptr>>(pd::function<Ptr, ptr>());
+        }
+
+#ifdef __cpp_nontype_template_parameter_auto
+        /**
+           Краткая запись для C++17: pipe_op_factory<&f>()
+        */
+        template <auto ptr>
+        auto pipe_op_factory() {
+            return pd::pipe_op_factory<decltype(ptr), ptr>();
+        }
+#endif /* __cpp_nontype_template_parameter_auto */
+
     } /* namespace details */
 
 } /* namespace pipeline */
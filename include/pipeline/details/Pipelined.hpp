@@ -0,0 +1,330 @@
+/**
+   \file
+
+   Конвейерное выполнение: каждая стадия работает в своём потоке.
+
+   \code
+   auto result = records | pipelined(parse, enrich, encode);
+   \endcode
+
+   Источник(контейнер или представление из Range.hpp) читается в
+   отдельном потоке. Стадии соединены очередями SpscQueue, поэтому
+   пока стадия N обрабатывает элемент i, стадия N+1 обрабатывает
+   элемент i-1. Последняя стадия выполняется в вызывающем потоке и
+   складывает результаты в std::vector в исходном порядке. Если
+   последняя стадия возвращает void, то результата нет.
+
+   Если очередь заполнена, то писатель ждёт пока читатель её
+   разгрузит. Так быстрая стадия не убегает вперёд медленной и
+   память не растёт.
+
+   Стадиями могут быть PipeOp и любые функциональные объекты.
+   Перед запуском стадии копируются, и каждую копию вызывает
+   только один поток, поэтому стадии могут иметь состояние.
+*/
+
+#pragma once
+
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Range.hpp>
+#include <pipeline/details/SpscQueue.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Общее состояние потоков одного запуска конвейера.
+           Если какой-то поток бросил исключение, то остальные
+           потоки прекращают ждать очередей и завершаются.
+        */
+        class PipelinedControl final {
+            std::atomic<bool> m_cancelled;
+            std::mutex m_mutex;
+            std::exception_ptr m_error;
+        public:
+            PipelinedControl()
+                : m_cancelled(false) {}
+
+            bool cancelled() const {
+                return m_cancelled.load(std::memory_order_relaxed);
+            }
+
+            /**
+               Выполняет func, перехватывая исключения
+            */
+            template <class Func>
+            void guard(Func&& func) {
+#ifdef __cpp_exceptions
+                try {
+                    func();
+                } catch(...) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if(!m_error)
+                        m_error = std::current_exception();
+                    m_cancelled.store(true);
+                }
+#else
+                func();
+#endif /* __cpp_exceptions */
+            }
+
+            void rethrow() {
+#ifdef __cpp_exceptions
+                if(m_error)
+                    std::rethrow_exception(m_error);
+#endif /* __cpp_exceptions */
+            }
+
+            /**
+               Кладёт value в очередь, ожидая места.
+
+               \return false если конвейер остановлен
+            */
+            template <class T, class TValue>
+            bool push(SpscQueue<T>& queue, TValue&& value) {
+                unsigned spins = 0;
+                while(!queue.tryPush(std::forward<TValue>(value))) {
+                    if(cancelled())
+                        return false;
+                    backoff(spins);
+                }
+                return true;
+            }
+
+            /**
+               Извлекает элемент из очереди и передаёт его в func.
+
+               \return false если очередь закрыта и пуста, или
+               конвейер остановлен
+            */
+            template <class T, class Func>
+            bool pop(SpscQueue<T>& queue, Func&& func) {
+                unsigned spins = 0;
+                while(!queue.tryPop(func)) {
+                    if(cancelled())
+                        return false;
+                    if(queue.closed())
+                        return queue.tryPop(func);
+                    backoff(spins);
+                }
+                return true;
+            }
+        };
+
+        template <class In, class... Ops>
+        class StageChain;
+
+        /**
+           Последняя стадия. Выполняется в вызывающем потоке.
+        */
+        template <class In, class Op>
+        class StageChain<In, Op> final {
+            PipelinedControl& m_control;
+            SpscQueue<In> m_input;
+            Op& m_op;
+
+            template <class Result>
+            void drain(Result& result, std::false_type /* void */) {
+                while(m_control.pop(m_input, [this, &result](In&& value) {
+                            result.emplace_back(m_op(std::move(value)));
+                        })) {}
+            }
+
+            template <class Result>
+            void drain(Result&, std::true_type /* void */) {
+                while(m_control.pop(m_input, [this](In&& value) {
+                            m_op(std::move(value));
+                        })) {}
+            }
+        public:
+            using Output = decltype(std::declval<Op&>()(std::declval<In>()));
+
+            StageChain(PipelinedControl& control, std::size_t capacity, Op& op)
+                : m_control(control),
+                  m_input(capacity),
+                  m_op(op) {}
+
+            SpscQueue<In>& input() {
+                return m_input;
+            }
+
+            void start(std::vector<std::thread>&) {}
+
+            template <class Result>
+            void drain(Result& result) {
+                drain(result, std::is_void<Output>());
+            }
+        };
+
+        /**
+           Промежуточная стадия. Выполняется в своём потоке и
+           передаёт результаты следующей стадии.
+        */
+        template <class In, class Op, class... Rest>
+        class StageChain<In, Op, Rest...> final {
+            using Out = std::decay_t<decltype(std::declval<Op&>()(std::declval<In>()))>;
+
+            PipelinedControl& m_control;
+            SpscQueue<In> m_input;
+            Op& m_op;
+            StageChain<Out, Rest...> m_next;
+
+            void run() {
+                auto& output = m_next.input();
+                bool more = true;
+                while(more && m_control.pop(m_input, [this, &output, &more](In&& value) {
+                            more = m_control.push(output, m_op(std::move(value)));
+                        })) {}
+                output.close();
+            }
+        public:
+            using Output = typename StageChain<Out, Rest...>::Output;
+
+            template <class TOp, class... TRest>
+            StageChain(PipelinedControl& control, std::size_t capacity, TOp& op, TRest&... rest)
+                : m_control(control),
+                  m_input(capacity),
+                  m_op(op),
+                  m_next(control, capacity, rest...) {}
+
+            SpscQueue<In>& input() {
+                return m_input;
+            }
+
+            void start(std::vector<std::thread>& threads) {
+                threads.emplace_back([this] {
+                        m_control.guard([this] { run(); });
+                    });
+                m_next.start(threads);
+            }
+
+            template <class Result>
+            void drain(Result& result) {
+                m_next.drain(result);
+            }
+        };
+
+        /**
+           Тип результата конвейера: std::vector результатов
+           последней стадии или void
+        */
+        template <class Output>
+        struct PipelinedResult {
+            using type = std::vector<std::decay_t<Output>>;
+        };
+
+        template <>
+        struct PipelinedResult<void> {
+            struct type {};
+        };
+
+        /**
+           Функциональный объект стадии pipelined
+        */
+        template <class... Ops>
+        class PipelinedStage final {
+            std::tuple<Ops...> m_ops;
+            std::size_t m_capacity;
+
+            template <class Chain, class Range>
+            static void feed(PipelinedControl& control, Chain& chain, Range& range) {
+                using In = std::decay_t<typename AllView<Range&>::reference>;
+
+                auto& input = chain.input();
+                auto view = pd::all(range);
+                view.forEach([&control, &input](auto&& value) {
+                        return control.push(input, In(std::forward<decltype(value)>(value)));
+                    });
+                input.close();
+            }
+
+            template <class Range, std::size_t... I>
+            auto run(Range& range, std::index_sequence<I...>) const {
+                using In = std::decay_t<typename AllView<Range&>::reference>;
+                using Chain = StageChain<In, Ops...>;
+                using Output = typename Chain::Output;
+
+                // у каждого запуска свои копии стадий
+                std::tuple<Ops...> ops(m_ops);
+
+                PipelinedControl control;
+                Chain chain(control, m_capacity, std::get<I>(ops)...);
+                typename PipelinedResult<Output>::type result;
+
+                std::vector<std::thread> threads;
+                threads.emplace_back([&control, &chain, &range] {
+                        control.guard([&control, &chain, &range] {
+                                feed(control, chain, range);
+                            });
+                    });
+                chain.start(threads);
+
+                control.guard([&chain, &result] {
+                        chain.drain(result);
+                    });
+
+                for(auto& thread : threads)
+                    thread.join();
+                control.rethrow();
+
+                return finish(std::move(result), std::is_void<Output>());
+            }
+
+            template <class Result>
+            static Result finish(Result&& result, std::false_type /* void */) {
+                return std::move(result);
+            }
+
+            template <class Result>
+            static void finish(Result&&, std::true_type /* void */) {}
+        public:
+            PipelinedStage(std::size_t capacity, Ops... ops)
+                : m_ops(std::move(ops)...),
+                  m_capacity(capacity) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const {
+                return run(range, std::index_sequence_for<Ops...>());
+            }
+        };
+
+        /**
+           Ёмкость очередей между стадиями по умолчанию
+        */
+        constexpr std::size_t pipelined_capacity = 1024;
+
+        /**
+           Стадия выполняющая ops конвейером, каждую стадию
+           в своём потоке.
+
+           \param capacity ёмкость очереди перед каждой стадией
+        */
+        template <class... Ops>
+        auto pipelined_with(std::size_t capacity, Ops&&... ops) {
+            using Stage = PipelinedStage<std::decay_t<Ops>...>;
+            return PipeOp<Stage>(Stage(capacity, std::forward<Ops>(ops)...));
+        }
+
+        /**
+           Стадия выполняющая ops конвейером с ёмкостью
+           очередей pipelined_capacity
+        */
+        template <class... Ops>
+        auto pipelined(Ops&&... ops) {
+            return pd::pipelined_with(pipelined_capacity, std::forward<Ops>(ops)...);
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,362 @@
+/**
+   \file
+
+   Ленивые стадии для диапазонов: map, filter, take, drop и
+   to_vector.
+
+   Стадии не создают промежуточных контейнеров. Каждая из них
+   возвращает представление(view), которое хранит источник и
+   функцию. Представление не имеет итераторов, вместо этого оно
+   умеет передавать элементы в приёмник(sink) через forEach.
+   Приёмник возвращает false если больше элементов не нужно,
+   поэтому take останавливает весь проход сразу.
+
+   После инлайнинга вся цепочка превращается в один цикл по
+   исходному контейнеру:
+   \code
+   auto names = records | map(&Record::name) | filter(not_empty)
+       | take(10) | to_vector;
+   \endcode
+
+   Если источник -- lvalue, то представление хранит ссылку на него,
+   если rvalue -- то он перемещается внутрь представления.
+*/
+
+#pragma once
+
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Span.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Базовый класс для всех представлений. Нужен только
+           для того чтобы отличать представления от контейнеров.
+        */
+        struct RangeView {};
+
+        template <class T>
+        struct IsView : std::is_base_of<RangeView, T> {};
+
+        /**
+           Представление для контейнера или любого другого
+           типа у которого есть begin и end.
+
+           \tparam Range тип контейнера. Если это ссылка, то
+           контейнер не хранится, а только используется.
+        */
+        template <class Range>
+        class ContainerView final : public RangeView {
+            Range m_range;
+        public:
+            using reference = decltype(*std::begin(std::declval<std::remove_reference_t<Range>&>()));
+
+            explicit ContainerView(Range&& range)
+                : m_range(std::forward<Range>(range)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                for(auto&& value : m_range)
+                    if(!sink(value))
+                        return false;
+                return true;
+            }
+        };
+
+        /**
+           Представление ссылающееся на другое представление.
+           Используется когда представление передано как lvalue.
+        */
+        template <class View>
+        class ViewRef final : public RangeView {
+            View* m_view;
+        public:
+            using reference = typename View::reference;
+
+            explicit ViewRef(View& view)
+                : m_view(&view) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return m_view->forEach(std::forward<Sink>(sink));
+            }
+        };
+
+        /**
+           Вспомогательный класс для all. Выбирает представление
+           по тому чем является Range и как он передан.
+        */
+        class All {
+        public:
+            template <class Range>
+            static auto make(Range&& range, std::true_type /* view */, std::true_type /* lvalue */) {
+                return ViewRef<std::remove_reference_t<Range>>(range);
+            }
+
+            template <class Range>
+            static auto make(Range&& range, std::true_type /* view */, std::false_type /* lvalue */) {
+                return std::decay_t<Range>(std::move(range));
+            }
+
+            template <class Range, class IsLvalue>
+            static auto make(Range&& range, std::false_type /* view */, IsLvalue) {
+                return ContainerView<Range>(std::forward<Range>(range));
+            }
+        };
+
+        /**
+           Превращает контейнер или представление в представление
+        */
+        template <class Range>
+        auto all(Range&& range) {
+            return All::make(std::forward<Range>(range),
+                             IsView<std::decay_t<Range>>(),
+                             std::is_lvalue_reference<Range>());
+        }
+
+        template <class Range>
+        using AllView = decltype(pd::all(std::declval<Range>()));
+
+        /**
+           Представление применяющее Func к каждому элементу Src
+        */
+        template <class Src, class Func>
+        class MapView final : public RangeView {
+            Src m_src;
+            Func m_func;
+        public:
+            using reference = decltype(std::declval<Func&>()(std::declval<typename Src::reference>()));
+
+            MapView(Src src, Func func)
+                : m_src(std::move(src)),
+                  m_func(std::move(func)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return m_src.forEach([this, &sink](auto&& value) {
+                        return sink(m_func(std::forward<decltype(value)>(value)));
+                    });
+            }
+        };
+
+        /**
+           Представление пропускающее только элементы Src
+           для которых Pred вернул true
+        */
+        template <class Src, class Pred>
+        class FilterView final : public RangeView {
+            Src m_src;
+            Pred m_pred;
+        public:
+            using reference = typename Src::reference;
+
+            FilterView(Src src, Pred pred)
+                : m_src(std::move(src)),
+                  m_pred(std::move(pred)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return m_src.forEach([this, &sink](auto&& value) {
+                        if(!m_pred(value))
+                            return true;
+                        return sink(std::forward<decltype(value)>(value));
+                    });
+            }
+        };
+
+        /**
+           Представление содержащее не больше count первых
+           элементов Src. Проход по Src прекращается как только
+           набрано count элементов.
+        */
+        template <class Src>
+        class TakeView final : public RangeView {
+            Src m_src;
+            std::size_t m_count;
+        public:
+            using reference = typename Src::reference;
+
+            TakeView(Src src, std::size_t count)
+                : m_src(std::move(src)),
+                  m_count(count) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                if(m_count == 0)
+                    return true;
+
+                std::size_t left = m_count;
+                bool more = true;
+                m_src.forEach([&left, &more, &sink](auto&& value) {
+                        more = sink(std::forward<decltype(value)>(value));
+                        return more && --left != 0;
+                    });
+                return more;
+            }
+        };
+
+        /**
+           Представление без первых count элементов Src
+        */
+        template <class Src>
+        class DropView final : public RangeView {
+            Src m_src;
+            std::size_t m_count;
+        public:
+            using reference = typename Src::reference;
+
+            DropView(Src src, std::size_t count)
+                : m_src(std::move(src)),
+                  m_count(count) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                std::size_t left = m_count;
+                return m_src.forEach([&left, &sink](auto&& value) {
+                        if(left != 0) {
+                            --left;
+                            return true;
+                        }
+                        return sink(std::forward<decltype(value)>(value));
+                    });
+            }
+        };
+
+        /**
+           Функциональный объект стадии map
+        */
+        template <class Func>
+        class MapStage final {
+            Func m_func;
+        public:
+            explicit MapStage(Func func)
+                : m_func(std::move(func)) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const & {
+                return MapView<AllView<Range>, Func>(pd::all(std::forward<Range>(range)), m_func);
+            }
+
+            template <class Range>
+            auto operator()(Range&& range) && {
+                return MapView<AllView<Range>, Func>(pd::all(std::forward<Range>(range)), std::move(m_func));
+            }
+        };
+
+        /**
+           Функциональный объект стадии filter
+        */
+        template <class Pred>
+        class FilterStage final {
+            Pred m_pred;
+        public:
+            explicit FilterStage(Pred pred)
+                : m_pred(std::move(pred)) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const & {
+                return FilterView<AllView<Range>, Pred>(pd::all(std::forward<Range>(range)), m_pred);
+            }
+
+            template <class Range>
+            auto operator()(Range&& range) && {
+                return FilterView<AllView<Range>, Pred>(pd::all(std::forward<Range>(range)), std::move(m_pred));
+            }
+        };
+
+        /**
+           Функциональный объект стадий take и drop
+
+           \tparam View шаблон представления: TakeView или DropView
+        */
+        template <template <class> class View>
+        class CountStage final {
+            std::size_t m_count;
+        public:
+            explicit CountStage(std::size_t count)
+                : m_count(count) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const {
+                return View<AllView<Range>>(pd::all(std::forward<Range>(range)), m_count);
+            }
+        };
+
+        /**
+           Функциональный объект собирающий элементы
+           представления или контейнера в std::vector.
+
+           Представления которые выдают Span по значению(batch,
+           map_batch) переиспользуют буфер, и собранные Span
+           ссылались бы на последний пакет. Для них оператор не
+           подходит: сначала нужен unbatch.
+        */
+        struct ToVector final {
+            template <class Range,
+                      class View = decltype(pd::all(std::declval<Range>())),
+                      class = std::enable_if_t<!IsSpan<typename View::reference>::value>>
+            auto operator()(Range&& range) const {
+                auto view = pd::all(std::forward<Range>(range));
+
+                std::vector<std::decay_t<typename decltype(view)::reference>> result;
+                view.forEach([&result](auto&& value) {
+                        result.push_back(std::forward<decltype(value)>(value));
+                        return true;
+                    });
+                return result;
+            }
+        };
+
+        /**
+           Стадия применяющая func к каждому элементу.
+           func может быть функцией, методом или функциональным
+           объектом, так же как и в pipe_op.
+        */
+        template <class Func>
+        auto map(Func&& func) {
+            auto callable = pd::function(std::forward<Func>(func));
+            return PipeOp<MapStage<decltype(callable)>>(MapStage<decltype(callable)>(std::move(callable)));
+        }
+
+        /**
+           Стадия оставляющая элементы для которых pred
+           вернул true
+        */
+        template <class Pred>
+        auto filter(Pred&& pred) {
+            auto callable = pd::function(std::forward<Pred>(pred));
+            return PipeOp<FilterStage<decltype(callable)>>(FilterStage<decltype(callable)>(std::move(callable)));
+        }
+
+        /**
+           Стадия оставляющая первые count элементов
+        */
+        inline auto take(std::size_t count) {
+            return PipeOp<CountStage<TakeView>>(CountStage<TakeView>(count));
+        }
+
+        /**
+           Стадия пропускающая первые count элементов
+        */
+        inline auto drop(std::size_t count) {
+            return PipeOp<CountStage<DropView>>(CountStage<DropView>(count));
+        }
+
+        /**
+           Стадия собирающая элементы в std::vector: vec | map(f) | to_vector
+        */
+        constexpr PipeOp<ToVector> to_vector{ToVector()};
+
+    } /* namespace details */
+
+} /* namespace pipeline */
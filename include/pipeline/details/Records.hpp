@@ -0,0 +1,305 @@
+/**
+   \file
+
+   Стадии records и fixed_records режут текст или двоичные данные
+   на записи без копирования:
+   \code
+   auto file = map_file("access.log");
+   std::size_t errors = *file | records('\n') | filter(is_error)
+       | map(parse) | take(100) | ...;
+   \endcode
+
+   Вход -- MappedFile, std::string_view, std::string или диапазон
+   из них(например std::vector<MappedFile> от map_files). Выход --
+   ленивое представление(см. Range.hpp) со значениями
+   std::string_view, которые указывают в исходный буфер. Копия
+   появляется только если стадия сама построит из записи
+   std::string.
+
+   records(delim) отдаёт куски между разделителями, сам
+   разделитель в запись не входит. Если буфер не заканчивается
+   разделителем, то остаток -- это последняя запись. Пустые записи
+   между двумя разделителями сохраняются.
+
+   Временный std::string или MappedFile(и диапазон из них) не
+   принимается: представление хранило бы его копию, и записи
+   повисли бы в конце выражения. Такой буфер нужно сначала
+   сохранить в переменную. Временный std::string_view подходит.
+
+   fixed_records(size) отдаёт записи по size байт. Неполная
+   запись в конце буфера отбрасывается.
+
+   split(delim, n) режет так же как records(delim), но отдаёт
+   пакеты по n записей как Span<const std::string_view>, подобно
+   batch(n). Разделители ищутся векторно(см. DelimiterScan.hpp),
+   records(delim) использует тот же поиск. Как и для batch(n),
+   split() | to_vector не компилируется: нужен unbatch.
+
+   Только для C++17.
+*/
+
+#pragma once
+
+#include <pipeline/details/DelimiterScan.hpp>
+#include <pipeline/details/MappedFile.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Range.hpp>
+#include <pipeline/details/Span.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __cpp_lib_string_view
+
+namespace pipeline {
+
+    namespace details {
+
+        inline std::string_view as_buffer(const MappedFile& file) {
+            return file.view();
+        }
+
+        inline std::string_view as_buffer(std::string_view buffer) {
+            return buffer;
+        }
+
+        inline std::string_view as_buffer(const std::string& buffer) {
+            return buffer;
+        }
+
+        template <class T, class = void>
+        struct IsBuffer : std::false_type {};
+
+        template <class T>
+        struct IsBuffer<T, VoidT<decltype(pd::as_buffer(std::declval<const T&>()))>>
+            : std::true_type {};
+
+        template <class T, class = void>
+        struct IsBufferRange : std::false_type {};
+
+        template <class T>
+        struct IsBufferRange<T, std::enable_if_t<IsBuffer<std::decay_t<decltype(*std::begin(std::declval<const T&>()))>>::value>>
+            : std::true_type {};
+
+        /**
+           Буфер, который владеет своими данными
+        */
+        template <class T>
+        struct OwnsBuffer : std::false_type {};
+
+        template <>
+        struct OwnsBuffer<std::string> : std::true_type {};
+
+        template <>
+        struct OwnsBuffer<MappedFile> : std::true_type {};
+
+        template <class T, class = void>
+        struct OwnsBuffers : OwnsBuffer<T> {};
+
+        template <class T>
+        struct OwnsBuffers<T, std::enable_if_t<IsBufferRange<T>::value>>
+            : OwnsBuffer<std::decay_t<decltype(*std::begin(std::declval<const T&>()))>> {};
+
+        /**
+           Источник для records и split: буфер или диапазон
+           буферов, но не временный владеющий буфер
+        */
+        template <class Source,
+                  class T = std::decay_t<Source>>
+        using IsRecordsSource = std::integral_constant<bool,
+                                                       (IsBuffer<T>::value || IsBufferRange<T>::value) &&
+                                                       (std::is_lvalue_reference<Source>::value || !OwnsBuffers<T>::value)>;
+
+        /**
+           Вспомогательный класс для обхода одного буфера
+           или диапазона буферов
+        */
+        class Buffers {
+        public:
+            template <class Source, class Func>
+            static bool forEach(const Source& source, Func&& func, std::true_type /* buffer */) {
+                return func(pd::as_buffer(source));
+            }
+
+            template <class Source, class Func>
+            static bool forEach(const Source& source, Func&& func, std::false_type /* buffer */) {
+                for(const auto& buffer : source)
+                    if(!func(pd::as_buffer(buffer)))
+                        return false;
+                return true;
+            }
+        };
+
+        /**
+           Разбиение по разделителю
+        */
+        class DelimiterSplit final {
+            char m_delim;
+        public:
+            explicit DelimiterSplit(char delim)
+                : m_delim(delim) {}
+
+            template <class Sink>
+            bool operator()(std::string_view buffer, Sink& sink) const {
+                return pd::scan_records(buffer.data(), buffer.size(), m_delim,
+                                        [&sink](const char* begin, const char* end) {
+                                            return sink(std::string_view(begin, end - begin));
+                                        });
+            }
+        };
+
+        /**
+           Разбиение на записи одного размера
+        */
+        class FixedSplit final {
+            std::size_t m_size;
+        public:
+            explicit FixedSplit(std::size_t size)
+                : m_size(size) {}
+
+            template <class Sink>
+            bool operator()(std::string_view buffer, Sink& sink) const {
+                if(m_size == 0)
+                    return true;
+                for(std::size_t offset = 0; buffer.size() - offset >= m_size; offset += m_size)
+                    if(!sink(buffer.substr(offset, m_size)))
+                        return false;
+                return true;
+            }
+        };
+
+        /**
+           Представление с записями из Source.
+
+           \tparam Source буфер или диапазон буферов. Если это
+           ссылка, то источник не хранится, а только используется.
+        */
+        template <class Source, class Split>
+        class RecordsView final : public RangeView {
+            Source m_source;
+            Split m_split;
+        public:
+            using reference = std::string_view;
+
+            RecordsView(Source&& source, Split split)
+                : m_source(std::forward<Source>(source)),
+                  m_split(std::move(split)) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                return Buffers::forEach(m_source, [this, &sink](std::string_view buffer) {
+                        return m_split(buffer, sink);
+                    }, IsBuffer<std::decay_t<Source>>());
+            }
+        };
+
+        /**
+           Представление с пакетами записей из Source. Буфер
+           пакета переиспользуется, поэтому Span действителен
+           только до следующего пакета, и to_vector для этого
+           представления не подходит(см. ToVector).
+        */
+        template <class Source>
+        class SplitView final : public RangeView {
+            Source m_source;
+            char m_delim;
+            std::size_t m_size;
+        public:
+            using reference = Span<const std::string_view>;
+
+            SplitView(Source&& source, char delim, std::size_t size)
+                : m_source(std::forward<Source>(source)),
+                  m_delim(delim),
+                  m_size(size == 0 ? 1 : size) {}
+
+            template <class Sink>
+            bool forEach(Sink&& sink) {
+                std::vector<std::string_view> batch;
+                batch.reserve(m_size);
+
+                const bool more = Buffers::forEach(m_source, [this, &sink, &batch](std::string_view buffer) {
+                        return pd::scan_records(buffer.data(), buffer.size(), m_delim,
+                                                [this, &sink, &batch](const char* begin, const char* end) {
+                                                    batch.emplace_back(begin, end - begin);
+                                                    if(batch.size() < m_size)
+                                                        return true;
+                                                    const bool more = sink(reference(batch.data(), batch.size()));
+                                                    batch.clear();
+                                                    return more;
+                                                });
+                    }, IsBuffer<std::decay_t<Source>>());
+
+                if(!more)
+                    return false;
+                if(batch.empty())
+                    return true;
+                return sink(reference(batch.data(), batch.size()));
+            }
+        };
+
+        /**
+           Функциональный объект стадии split
+        */
+        class SplitStage final {
+            char m_delim;
+            std::size_t m_size;
+        public:
+            SplitStage(char delim, std::size_t size)
+                : m_delim(delim),
+                  m_size(size) {}
+
+            template <class Source,
+                      class = std::enable_if_t<IsRecordsSource<Source>::value>>
+            auto operator()(Source&& source) const {
+                return SplitView<Source>(std::forward<Source>(source), m_delim, m_size);
+            }
+        };
+
+        /**
+           Функциональный объект стадий records и fixed_records
+        */
+        template <class Split>
+        class RecordsStage final {
+            Split m_split;
+        public:
+            explicit RecordsStage(Split split)
+                : m_split(std::move(split)) {}
+
+            template <class Source,
+                      class = std::enable_if_t<IsRecordsSource<Source>::value>>
+            auto operator()(Source&& source) const {
+                return RecordsView<Source, Split>(std::forward<Source>(source), m_split);
+            }
+        };
+
+        /**
+           Стадия режущая буфер на записи по разделителю delim
+        */
+        inline auto records(char delim = '\n') {
+            return PipeOp<RecordsStage<DelimiterSplit>>(RecordsStage<DelimiterSplit>(DelimiterSplit(delim)));
+        }
+
+        /**
+           Стадия режущая буфер по разделителю delim на пакеты
+           по size записей
+        */
+        inline auto split(char delim = '\n', std::size_t size = 1024) {
+            return PipeOp<SplitStage>(SplitStage(delim, size));
+        }
+
+        /**
+           Стадия режущая буфер на записи по size байт
+        */
+        inline auto fixed_records(std::size_t size) {
+            return PipeOp<RecordsStage<FixedSplit>>(RecordsStage<FixedSplit>(FixedSplit(size)));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_string_view */
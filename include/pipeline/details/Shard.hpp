@@ -0,0 +1,175 @@
+/**
+   \file
+
+   Стадия shard_by делит диапазон между N потоками по ключу:
+   \code
+   records | shard_by(&Record::m_user, 8, sessionize);
+   \endcode
+
+   Для каждого элемента вычисляется key(x), и по хешу ключа
+   выбирается поток. Элементы с одинаковым ключом всегда попадают
+   в один поток и приходят в нём в исходном порядке. Ключом может
+   быть функция, метод или поле класса.
+
+   Каждый поток вызывает свою копию downstream(PipeOp или любого
+   функционального объекта), поэтому downstream может хранить
+   состояние по ключам(сессии, множество уже виденных ключей и
+   т.п.) без мьютексов: копию использует только один поток.
+
+   Источник(контейнер или представление из Range.hpp) читается в
+   вызывающем потоке и раскладывается по очередям SpscQueue, как
+   в pipelined(см. Pipelined.hpp). Результаты downstream
+   собираются в std::vector: сначала все результаты потока 0,
+   потом потока 1 и т.д. Если downstream возвращает void, то
+   результата нет.
+*/
+
+#pragma once
+
+#include <pipeline/details/CacheLine.hpp>
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/Pipelined.hpp>
+#include <pipeline/details/Range.hpp>
+#include <pipeline/details/SpscQueue.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Функциональный объект стадии shard_by
+        */
+        template <class Key, class Op>
+        class ShardStage final {
+            template <class In>
+            using Output = decltype(std::declval<Op&>()(std::declval<In>()));
+
+            /**
+               Поток со своей очередью и своей копией downstream
+            */
+            template <class In>
+            struct Worker {
+                SpscQueue<In> m_input;
+                Op m_op;
+                typename PipelinedResult<Output<In>>::type m_result;
+
+                Worker(std::size_t capacity, const Op& op)
+                    : m_input(capacity),
+                      m_op(op) {}
+
+                void run(PipelinedControl& control) {
+                    run(control, std::is_void<Output<In>>());
+                }
+
+                void run(PipelinedControl& control, std::false_type /* void */) {
+                    while(control.pop(m_input, [this](In&& value) {
+                                m_result.emplace_back(m_op(std::move(value)));
+                            })) {}
+                }
+
+                void run(PipelinedControl& control, std::true_type /* void */) {
+                    while(control.pop(m_input, [this](In&& value) {
+                                m_op(std::move(value));
+                            })) {}
+                }
+            };
+
+            Key m_key;
+            Op m_op;
+            std::size_t m_shards;
+            std::size_t m_capacity;
+
+            template <class In>
+            std::size_t shard(const In& value) const {
+                using KeyType = std::decay_t<decltype(m_key(value))>;
+                const std::size_t hash = std::hash<KeyType>()(m_key(value));
+                // младшие биты std::hash для целых -- само число
+                const std::uint64_t mixed = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+                return (mixed >> 32) % m_shards;
+            }
+
+            template <class Workers>
+            static auto collect(Workers& workers, std::false_type /* void */) {
+                auto result = std::move(workers.front()->m_result);
+                for(std::size_t i = 1; i < workers.size(); ++i)
+                    std::move(workers[i]->m_result.begin(), workers[i]->m_result.end(), std::back_inserter(result));
+                return result;
+            }
+
+            template <class Workers>
+            static void collect(Workers&, std::true_type /* void */) {}
+        public:
+            ShardStage(Key key, Op op, std::size_t shards, std::size_t capacity)
+                : m_key(std::move(key)),
+                  m_op(std::move(op)),
+                  m_shards(std::max<std::size_t>(shards, 1)),
+                  m_capacity(capacity) {}
+
+            template <class Range>
+            auto operator()(Range&& range) const {
+                using In = std::decay_t<typename AllView<Range&>::reference>;
+
+                std::vector<AlignedPtr<Worker<In>>> workers;
+                for(std::size_t i = 0; i < m_shards; ++i)
+                    workers.push_back(make_aligned<Worker<In>>(m_capacity, m_op));
+
+                PipelinedControl control;
+                std::vector<std::thread> threads;
+                for(auto& worker : workers) {
+                    Worker<In>* current = worker.get();
+                    threads.emplace_back([&control, current] {
+                            control.guard([&control, current] {
+                                    current->run(control);
+                                });
+                        });
+                }
+
+                control.guard([this, &control, &workers, &range] {
+                        auto view = pd::all(range);
+                        view.forEach([this, &control, &workers](auto&& value) {
+                                In item(std::forward<decltype(value)>(value));
+                                auto& input = workers[shard(item)]->m_input;
+                                return control.push(input, std::move(item));
+                            });
+                    });
+                for(auto& worker : workers)
+                    worker->m_input.close();
+
+                for(auto& thread : threads)
+                    thread.join();
+                control.rethrow();
+
+                return collect(workers, std::is_void<Output<In>>());
+            }
+        };
+
+        /**
+           Стадия распределяющая элементы между shards потоками
+           по key(x). Каждый поток вызывает свою копию downstream.
+
+           \param capacity ёмкость очереди каждого потока
+        */
+        template <class Key, class Op>
+        auto shard_by(Key&& key, std::size_t shards, Op&& downstream,
+                      std::size_t capacity = pipelined_capacity) {
+            auto key_callable = pd::function(std::forward<Key>(key));
+            auto op_callable = pd::function(std::forward<Op>(downstream));
+            using Stage = ShardStage<decltype(key_callable), decltype(op_callable)>;
+            return PipeOp<Stage>(Stage(std::move(key_callable), std::move(op_callable), shards, capacity));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,359 @@
+/**
+   \file
+
+   Стадии simd_map и simd_filter для непрерывных массивов чисел
+   (std::vector, std::array, Span) с элементами float, double,
+   std::int32_t или std::int64_t:
+   \code
+   std::vector<float> scaled = samples | simd_map([](auto x) { return min(x * 1.5f, 100.f); });
+   std::vector<float> positive = samples | simd_filter([](auto x) { return x > 0; });
+   \endcode
+
+   Функция вызывается не для каждого значения, а для Pack из
+   16, 32 или 64 байт(см. SimdPack.hpp), поэтому она должна быть
+   обобщённой. simd_map возвращает Pack той же ширины, возможно
+   с другим типом элементов(pack_cast), simd_filter -- Mask.
+   Остаток массива короче Pack обрабатывается скалярно: функция
+   вызывается для Pack<T, 1>.
+
+   Ядра собраны для SSE2, AVX2 и AVX-512, а нужное выбирается во
+   время выполнения(см. SimdLevel.hpp). Вторым аргументом стадии
+   можно задать уровень явно, например для сравнения.
+
+   simd_filter сжимает выбранные элементы инструкцией compress
+   на AVX-512 и перестановкой по таблице на AVX2. На SSE2 и в
+   скалярном ядре элементы пишутся всегда, а указатель записи
+   сдвигается только для выбранных.
+
+   Результат стадий -- std::vector.
+*/
+
+#pragma once
+
+#include <pipeline/details/Callable.hpp>
+#include <pipeline/details/Namespaces.hpp>
+#include <pipeline/details/PipeOp.hpp>
+#include <pipeline/details/SimdLevel.hpp>
+#include <pipeline/details/SimdPack.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define PIPELINE_ALWAYS_INLINE __attribute__((always_inline)) inline
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Непрерывный массив из чисел размера 4 или 8 байт
+        */
+        template <class T, class = void>
+        struct IsSimdRange : std::false_type {};
+
+        template <class T>
+        struct IsSimdRange<T, VoidT<decltype(std::declval<const T&>().data() + std::declval<const T&>().size())>> {
+            using value_type = std::remove_cv_t<std::remove_pointer_t<decltype(std::declval<const T&>().data())>>;
+
+            static constexpr bool value = std::is_arithmetic<value_type>::value &&
+                (sizeof(value_type) == 4 || sizeof(value_type) == 8);
+        };
+
+        template <class Range>
+        using SimdValue = typename IsSimdRange<std::decay_t<Range>>::value_type;
+
+        /**
+           Тип элементов результата func
+        */
+        template <class T, class Func>
+        using SimdMapValue = typename decltype(std::declval<Func&>()(std::declval<Pack<T, 1>>()))::value_type;
+
+        /**
+           Применяет func ко всем Pack по Bytes байт и к остатку
+        */
+        template <std::size_t Bytes, class T, class U, class Func>
+        PIPELINE_ALWAYS_INLINE void simd_map_loop(const T* in, std::size_t size, U* out, Func& func) {
+            constexpr std::size_t N = Bytes / sizeof(T);
+            std::size_t i = 0;
+            for(; i + N <= size; i += N) {
+                const Pack<U, N> result = func(Pack<T, N>::load(in + i));
+                result.store(out + i);
+            }
+            for(; i < size; ++i) {
+                const Pack<U, 1> result = func(Pack<T, 1>(in[i]));
+                out[i] = result[0];
+            }
+        }
+
+        template <class T, class U, class Func>
+        void simd_map_scalar(const T* in, std::size_t size, U* out, Func& func) {
+            simd_map_loop<sizeof(T)>(in, size, out, func);
+        }
+
+        /**
+           Пишет все элементы Pack, но сдвигает count только на
+           выбранных
+        */
+        template <class T, std::size_t N>
+        PIPELINE_ALWAYS_INLINE std::size_t compress_bits(const T* in, const Mask<T, N>& mask, T* out,
+                                                         std::size_t count) {
+            for(std::size_t i = 0; i < N; ++i) {
+                out[count] = in[i];
+                count += mask.lanes()[i] & 1;
+            }
+            return count;
+        }
+
+        /**
+           Оставляет элементы для которых pred вернул установленную
+           маску. В out должно быть место для size элементов и ещё
+           одного Pack.
+
+           \return число оставленных элементов
+        */
+        template <std::size_t Bytes, class T, class Pred, class Compress>
+        PIPELINE_ALWAYS_INLINE std::size_t simd_filter_loop(const T* in, std::size_t size, T* out, Pred& pred,
+                                                            Compress compress) {
+            constexpr std::size_t N = Bytes / sizeof(T);
+            std::size_t count = 0;
+            std::size_t i = 0;
+            for(; i + N <= size; i += N)
+                count = compress(in + i, pred(Pack<T, N>::load(in + i)), out, count);
+            for(; i < size; ++i)
+                count = compress_bits(in + i, pred(Pack<T, 1>(in[i])), out, count);
+            return count;
+        }
+
+        template <class T, class Pred>
+        std::size_t simd_filter_scalar(const T* in, std::size_t size, T* out, Pred& pred) {
+            return simd_filter_loop<sizeof(T)>(in, size, out, pred, [](const T* in, const Mask<T, 1>& mask,
+                                                                      T* out, std::size_t count) {
+                    return compress_bits(in, mask, out, count);
+                });
+        }
+
+#ifdef PIPELINE_X86_SIMD
+        template <class T, class U, class Func>
+        void simd_map_sse2(const T* in, std::size_t size, U* out, Func& func) {
+            simd_map_loop<16>(in, size, out, func);
+        }
+
+        template <class T, class U, class Func>
+        __attribute__((target("avx2")))
+        void simd_map_avx2(const T* in, std::size_t size, U* out, Func& func) {
+            simd_map_loop<32>(in, size, out, func);
+        }
+
+        template <class T, class U, class Func>
+        __attribute__((target("avx512f")))
+        void simd_map_avx512(const T* in, std::size_t size, U* out, Func& func) {
+            simd_map_loop<64>(in, size, out, func);
+        }
+
+        template <class T, class Pred>
+        std::size_t simd_filter_sse2(const T* in, std::size_t size, T* out, Pred& pred) {
+            return simd_filter_loop<16>(in, size, out, pred, [](const T* in, const Mask<T, 16 / sizeof(T)>& mask,
+                                                               T* out, std::size_t count) {
+                    return compress_bits(in, mask, out, count);
+                });
+        }
+
+        /**
+           Таблица перестановок для AVX2: для каждой маски из
+           восьми 32-битных элементов -- индексы выбранных
+           элементов, собранные в начало
+        */
+        struct CompressTable {
+            std::uint32_t m_indices[256][8];
+
+            constexpr CompressTable()
+                : m_indices{} {
+                for(std::uint32_t mask = 0; mask < 256; ++mask) {
+                    std::uint32_t count = 0;
+                    for(std::uint32_t i = 0; i < 8; ++i)
+                        if(mask & (1u << i))
+                            m_indices[mask][count++] = i;
+                }
+            }
+        };
+
+        inline const CompressTable& compress_table() {
+            static constexpr CompressTable table = CompressTable();
+            return table;
+        }
+
+        /**
+           Маска из 32-битных элементов как 8 бит. Для 64-битных
+           элементов каждый бит повторяется дважды, тогда та же
+           таблица переставляет пары.
+        */
+        template <class T>
+        __attribute__((target("avx2")))
+        PIPELINE_ALWAYS_INLINE unsigned compress_mask_avx2(const Mask<T, 32 / sizeof(T)>& mask) {
+            const __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask.lanes()));
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(lanes)));
+        }
+
+        struct CompressAvx2 {
+            template <class T>
+            __attribute__((target("avx2")))
+            std::size_t operator()(const T* in, const Mask<T, 32 / sizeof(T)>& mask,
+                                                          T* out, std::size_t count) const {
+                const unsigned bits = compress_mask_avx2<T>(mask);
+                const __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(compress_table().m_indices[bits]));
+                const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count), _mm256_permutevar8x32_epi32(values, indices));
+                return count + __builtin_popcount(bits) * 4 / sizeof(T);
+            }
+        };
+
+        template <class T, class Pred>
+        __attribute__((target("avx2")))
+        std::size_t simd_filter_avx2(const T* in, std::size_t size, T* out, Pred& pred) {
+            return simd_filter_loop<32>(in, size, out, pred, CompressAvx2());
+        }
+
+        __attribute__((target("avx512f")))
+        PIPELINE_ALWAYS_INLINE std::size_t compress_avx512(const void* in, const std::int32_t* lanes,
+                                                           void* out, std::size_t count,
+                                                           std::integral_constant<std::size_t, 4>) {
+            const __m512i mask = _mm512_loadu_si512(lanes);
+            const __mmask16 bits = _mm512_test_epi32_mask(mask, mask);
+            _mm512_mask_compressstoreu_epi32(static_cast<std::int32_t*>(out) + count, bits, _mm512_loadu_si512(in));
+            return count + __builtin_popcount(bits);
+        }
+
+        __attribute__((target("avx512f")))
+        PIPELINE_ALWAYS_INLINE std::size_t compress_avx512(const void* in, const std::int64_t* lanes,
+                                                           void* out, std::size_t count,
+                                                           std::integral_constant<std::size_t, 8>) {
+            const __m512i mask = _mm512_loadu_si512(lanes);
+            const __mmask8 bits = _mm512_test_epi64_mask(mask, mask);
+            _mm512_mask_compressstoreu_epi64(static_cast<std::int64_t*>(out) + count, bits, _mm512_loadu_si512(in));
+            return count + __builtin_popcount(bits);
+        }
+
+        struct CompressAvx512 {
+            template <class T>
+            __attribute__((target("avx512f")))
+            std::size_t operator()(const T* in, const Mask<T, 64 / sizeof(T)>& mask,
+                                                          T* out, std::size_t count) const {
+                return compress_avx512(in, mask.lanes(), out, count, std::integral_constant<std::size_t, sizeof(T)>());
+            }
+        };
+
+        template <class T, class Pred>
+        __attribute__((target("avx512f")))
+        std::size_t simd_filter_avx512(const T* in, std::size_t size, T* out, Pred& pred) {
+            return simd_filter_loop<64>(in, size, out, pred, CompressAvx512());
+        }
+#endif /* PIPELINE_X86_SIMD */
+
+        template <class T, class U, class Func>
+        void simd_map_dispatch(SimdLevel level, const T* in, std::size_t size, U* out, const Func& func) {
+            switch(level) {
+#ifdef PIPELINE_X86_SIMD
+            case SimdLevel::avx512:
+                return simd_map_avx512(in, size, out, func);
+            case SimdLevel::avx2:
+                return simd_map_avx2(in, size, out, func);
+            case SimdLevel::sse2:
+                return simd_map_sse2(in, size, out, func);
+#endif /* PIPELINE_X86_SIMD */
+            default:
+                return simd_map_scalar(in, size, out, func);
+            }
+        }
+
+        template <class T, class Pred>
+        std::size_t simd_filter_dispatch(SimdLevel level, const T* in, std::size_t size, T* out, const Pred& pred) {
+            switch(level) {
+#ifdef PIPELINE_X86_SIMD
+            case SimdLevel::avx512:
+                return simd_filter_avx512(in, size, out, pred);
+            case SimdLevel::avx2:
+                return simd_filter_avx2(in, size, out, pred);
+            case SimdLevel::sse2:
+                return simd_filter_sse2(in, size, out, pred);
+#endif /* PIPELINE_X86_SIMD */
+            default:
+                return simd_filter_scalar(in, size, out, pred);
+            }
+        }
+
+        /**
+           Функциональный объект стадии simd_map
+        */
+        template <class Func>
+        class SimdMapStage final {
+            Func m_func;
+            SimdLevel m_level;
+        public:
+            SimdMapStage(Func func, SimdLevel level)
+                : m_func(std::move(func)),
+                  m_level(level) {}
+
+            template <class Range,
+                      class = std::enable_if_t<IsSimdRange<std::decay_t<Range>>::value>>
+            auto operator()(const Range& range) const {
+                using T = SimdValue<Range>;
+                using U = SimdMapValue<T, Func>;
+
+                std::vector<U> result(range.size());
+                simd_map_dispatch(m_level, range.data(), range.size(), result.data(), m_func);
+                return result;
+            }
+        };
+
+        /**
+           Функциональный объект стадии simd_filter
+        */
+        template <class Pred>
+        class SimdFilterStage final {
+            Pred m_pred;
+            SimdLevel m_level;
+        public:
+            SimdFilterStage(Pred pred, SimdLevel level)
+                : m_pred(std::move(pred)),
+                  m_level(level) {}
+
+            template <class Range,
+                      class = std::enable_if_t<IsSimdRange<std::decay_t<Range>>::value>>
+            auto operator()(const Range& range) const {
+                using T = SimdValue<Range>;
+
+                // ядро AVX2 пишет Pack целиком
+                std::vector<T> result(range.size() + 64 / sizeof(T));
+                result.resize(simd_filter_dispatch(m_level, range.data(), range.size(), result.data(), m_pred));
+                return result;
+            }
+        };
+
+        /**
+           Стадия применяющая func к Pack из элементов массива.
+           level не должен быть выше best_simd_level().
+        */
+        template <class Func>
+        auto simd_map(Func&& func, SimdLevel level = best_simd_level()) {
+            auto callable = pd::function(std::forward<Func>(func));
+            return PipeOp<SimdMapStage<decltype(callable)>>(SimdMapStage<decltype(callable)>(std::move(callable), level));
+        }
+
+        /**
+           Стадия оставляющая элементы массива, для которых
+           маска от pred установлена
+        */
+        template <class Pred>
+        auto simd_filter(Pred&& pred, SimdLevel level = best_simd_level()) {
+            auto callable = pd::function(std::forward<Pred>(pred));
+            return PipeOp<SimdFilterStage<decltype(callable)>>(SimdFilterStage<decltype(callable)>(std::move(callable), level));
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#undef PIPELINE_ALWAYS_INLINE
@@ -0,0 +1,47 @@
+/**
+   \file
+
+   Уровни SIMD и выбор лучшего из них во время выполнения.
+
+   Векторные ядра(DelimiterScan.hpp, Simd.hpp) собираются с
+   атрибутом target для каждого уровня, а нужное выбирается по
+   возможностям процессора(__builtin_cpu_supports). Поэтому
+   библиотеку не нужно собирать с -mavx2 или -mavx512f. На других
+   архитектурах и компиляторах используются скалярные ядра.
+*/
+
+#pragma once
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PIPELINE_X86_SIMD
+#include <immintrin.h>
+#endif /* defined(__x86_64__) && defined(__GNUC__) */
+
+namespace pipeline {
+
+    namespace details {
+
+        enum class SimdLevel {
+            scalar,
+            sse2,
+            avx2,
+            avx512
+        };
+
+        /**
+           Лучший набор инструкций доступный на этом процессоре
+        */
+        inline SimdLevel best_simd_level() {
+#ifdef PIPELINE_X86_SIMD
+            static const SimdLevel level = __builtin_cpu_supports("avx512f") ? SimdLevel::avx512
+                : __builtin_cpu_supports("avx2") ? SimdLevel::avx2
+                : SimdLevel::sse2;
+            return level;
+#else
+            return SimdLevel::scalar;
+#endif /* PIPELINE_X86_SIMD */
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,254 @@
+/**
+   \file
+
+   Pack<T, N> -- N значений типа T, над которыми операции
+   выполняются поэлементно. Mask<T, N> -- результат сравнения
+   таких наборов.
+
+   Функции для simd_map и simd_filter пишутся один раз для Pack
+   любой ширины:
+   \code
+   auto clamp = [](auto x) { return min(max(x * 1.5f, 0.f), 100.f); };
+   auto positive = [](auto x) { return x > 0; };
+   \endcode
+
+   Внутри Pack -- обычный массив, а операции -- циклы по нему. В
+   ядре собранном с target("avx2") или target("avx512f") они
+   встраиваются и векторизуются компилятором под этот набор
+   инструкций. Массив, а не векторный тип GCC, нужен для того,
+   чтобы Pack передавался по значению одинаково при любом target:
+   без встраивания(например с -O0) код медленнее, но правильный.
+
+   min, max, select, abs, sqrt и pack_cast находятся через ADL.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Целое того же размера что и T: элемент маски
+        */
+        template <class T>
+        using MaskLane = std::conditional_t<sizeof(T) == 8, std::int64_t, std::int32_t>;
+
+        template <class T, std::size_t N>
+        class Mask final {
+            MaskLane<T> m_values[N];
+        public:
+            static constexpr std::size_t width = N;
+
+            Mask() = default;
+
+            Mask(bool value) {
+                for(std::size_t i = 0; i < N; ++i)
+                    m_values[i] = value ? -1 : 0;
+            }
+
+            bool operator[](std::size_t index) const {
+                return m_values[index] != 0;
+            }
+
+            /**
+               Элементы маски, -1 или 0
+            */
+            const MaskLane<T>* lanes() const {
+                return m_values;
+            }
+
+            MaskLane<T>* lanes() {
+                return m_values;
+            }
+
+            /**
+               Бит i установлен если установлен элемент i
+            */
+            std::uint64_t bits() const {
+                std::uint64_t bits = 0;
+                for(std::size_t i = 0; i < N; ++i)
+                    bits |= static_cast<std::uint64_t>(m_values[i] & 1) << i;
+                return bits;
+            }
+
+            friend Mask operator&(const Mask& a, const Mask& b) {
+                Mask result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = a.m_values[i] & b.m_values[i];
+                return result;
+            }
+
+            friend Mask operator|(const Mask& a, const Mask& b) {
+                Mask result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = a.m_values[i] | b.m_values[i];
+                return result;
+            }
+
+            friend Mask operator^(const Mask& a, const Mask& b) {
+                Mask result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = a.m_values[i] ^ b.m_values[i];
+                return result;
+            }
+
+            friend Mask operator!(const Mask& a) {
+                Mask result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = ~a.m_values[i];
+                return result;
+            }
+        };
+
+        template <class T, std::size_t N>
+        class Pack final {
+            static_assert(std::is_arithmetic<T>::value, "Pack holds arithmetic values");
+
+            T m_values[N];
+
+            template <class Op>
+            static Pack apply(const Pack& a, const Pack& b, Op op) {
+                Pack result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = op(a.m_values[i], b.m_values[i]);
+                return result;
+            }
+
+            template <class Op>
+            static Mask<T, N> compare(const Pack& a, const Pack& b, Op op) {
+                Mask<T, N> result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.lanes()[i] = op(a.m_values[i], b.m_values[i]) ? -1 : 0;
+                return result;
+            }
+        public:
+            using value_type = T;
+            static constexpr std::size_t width = N;
+
+            Pack() = default;
+
+            /**
+               Все элементы равны value
+            */
+            Pack(T value) {
+                for(std::size_t i = 0; i < N; ++i)
+                    m_values[i] = value;
+            }
+
+            static Pack load(const T* data) {
+                Pack result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = data[i];
+                return result;
+            }
+
+            void store(T* data) const {
+                for(std::size_t i = 0; i < N; ++i)
+                    data[i] = m_values[i];
+            }
+
+            T operator[](std::size_t index) const {
+                return m_values[index];
+            }
+
+            T& operator[](std::size_t index) {
+                return m_values[index];
+            }
+
+            friend Pack operator+(const Pack& a, const Pack& b) {
+                return apply(a, b, [](T x, T y) { return static_cast<T>(x + y); });
+            }
+
+            friend Pack operator-(const Pack& a, const Pack& b) {
+                return apply(a, b, [](T x, T y) { return static_cast<T>(x - y); });
+            }
+
+            friend Pack operator*(const Pack& a, const Pack& b) {
+                return apply(a, b, [](T x, T y) { return static_cast<T>(x * y); });
+            }
+
+            friend Pack operator/(const Pack& a, const Pack& b) {
+                return apply(a, b, [](T x, T y) { return static_cast<T>(x / y); });
+            }
+
+            friend Pack operator-(const Pack& a) {
+                return Pack(0) - a;
+            }
+
+            friend Pack min(const Pack& a, const Pack& b) {
+                return apply(a, b, [](T x, T y) { return y < x ? y : x; });
+            }
+
+            friend Pack max(const Pack& a, const Pack& b) {
+                return apply(a, b, [](T x, T y) { return x < y ? y : x; });
+            }
+
+            /**
+               Элемент из a там где mask установлена, иначе из b
+            */
+            friend Pack select(const Mask<T, N>& mask, const Pack& a, const Pack& b) {
+                Pack result;
+                for(std::size_t i = 0; i < N; ++i)
+                    result.m_values[i] = mask.lanes()[i] ? a.m_values[i] : b.m_values[i];
+                return result;
+            }
+
+            friend Mask<T, N> operator==(const Pack& a, const Pack& b) {
+                return compare(a, b, [](T x, T y) { return x == y; });
+            }
+
+            friend Mask<T, N> operator!=(const Pack& a, const Pack& b) {
+                return compare(a, b, [](T x, T y) { return x != y; });
+            }
+
+            friend Mask<T, N> operator<(const Pack& a, const Pack& b) {
+                return compare(a, b, [](T x, T y) { return x < y; });
+            }
+
+            friend Mask<T, N> operator<=(const Pack& a, const Pack& b) {
+                return compare(a, b, [](T x, T y) { return x <= y; });
+            }
+
+            friend Mask<T, N> operator>(const Pack& a, const Pack& b) {
+                return compare(a, b, [](T x, T y) { return x > y; });
+            }
+
+            friend Mask<T, N> operator>=(const Pack& a, const Pack& b) {
+                return compare(a, b, [](T x, T y) { return x >= y; });
+            }
+        };
+
+        template <class T, std::size_t N>
+        Pack<T, N> abs(const Pack<T, N>& a) {
+            return select(a < T(0), -a, a);
+        }
+
+        template <class T, std::size_t N,
+                  class = std::enable_if_t<std::is_floating_point<T>::value>>
+        Pack<T, N> sqrt(const Pack<T, N>& a) {
+            Pack<T, N> result;
+            for(std::size_t i = 0; i < N; ++i)
+                result[i] = std::sqrt(a[i]);
+            return result;
+        }
+
+        /**
+           Поэлементное преобразование в Pack<U, N>
+        */
+        template <class U, class T, std::size_t N>
+        Pack<U, N> pack_cast(const Pack<T, N>& a) {
+            Pack<U, N> result;
+            for(std::size_t i = 0; i < N; ++i)
+                result[i] = static_cast<U>(a[i]);
+            return result;
+        }
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,77 @@
+/**
+   \file
+
+   Span -- непрерывный участок памяти: указатель и размер.
+   Упрощённая замена std::span, которого нет в C++14.
+
+   Span не владеет памятью.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace pipeline {
+
+    namespace details {
+
+        template <class T>
+        class Span final {
+            T* m_data;
+            std::size_t m_size;
+        public:
+            using value_type = T;
+            using iterator = T*;
+
+            constexpr Span()
+                : m_data(nullptr),
+                  m_size(0) {}
+
+            constexpr Span(T* data, std::size_t size)
+                : m_data(data),
+                  m_size(size) {}
+
+            /**
+               Преобразование Span<T> в Span<const T>
+            */
+            template <class U,
+                      class = std::enable_if_t<std::is_convertible<U(*)[], T(*)[]>::value>>
+            constexpr Span(const Span<U>& other)
+                : m_data(other.data()),
+                  m_size(other.size()) {}
+
+            constexpr T* data() const {
+                return m_data;
+            }
+
+            constexpr std::size_t size() const {
+                return m_size;
+            }
+
+            bool empty() const {
+                return m_size == 0;
+            }
+
+            T* begin() const {
+                return m_data;
+            }
+
+            T* end() const {
+                return m_data + m_size;
+            }
+
+            T& operator[](std::size_t index) const {
+                return m_data[index];
+            }
+        };
+
+        template <class T>
+        struct IsSpan : std::false_type {};
+
+        template <class T>
+        struct IsSpan<Span<T>> : std::true_type {};
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,152 @@
+/**
+   \file
+
+   SpscQueue -- ограниченная очередь без блокировок для одного
+   писателя и одного читателя(single producer, single consumer).
+
+   Очередь -- это кольцевой буфер размером в степень двойки.
+   Писатель двигает только m_tail, читатель только m_head, поэтому
+   достаточно acquire/release атомиков. Индексы лежат в разных
+   кэш-линиях, а каждая сторона держит копию чужого индекса, чтобы
+   не читать его на каждой операции.
+
+   Очередь не ждёт сама: tryPush и tryPop сразу возвращают false
+   если очередь полна или пуста. Ожидание с backoff делает
+   вызывающий код.
+*/
+
+#pragma once
+
+#include <pipeline/details/CacheLine.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Пауза в цикле ожидания: сначала крутимся, потом
+           отдаём квант времени другим потокам
+        */
+        inline void backoff(unsigned& spins) {
+            if(spins < 64) {
+                ++spins;
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        template <class T>
+        class SpscQueue final {
+            using Slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+            alignas(cache_line_size) std::atomic<std::size_t> m_head;
+            std::size_t m_cached_tail;
+
+            alignas(cache_line_size) std::atomic<std::size_t> m_tail;
+            std::size_t m_cached_head;
+
+            alignas(cache_line_size) std::atomic<bool> m_closed;
+            const std::size_t m_mask;
+            std::unique_ptr<Slot[]> m_slots;
+
+            static std::size_t roundUp(std::size_t capacity) {
+                std::size_t size = 1;
+                while(size < capacity)
+                    size <<= 1;
+                return size;
+            }
+
+            T* slot(std::size_t index) {
+                return reinterpret_cast<T*>(&m_slots[index & m_mask]);
+            }
+        public:
+            /**
+               \param capacity минимальная ёмкость, округляется
+               вверх до степени двойки
+            */
+            explicit SpscQueue(std::size_t capacity)
+                : m_head(0),
+                  m_cached_tail(0),
+                  m_tail(0),
+                  m_cached_head(0),
+                  m_closed(false),
+                  m_mask(roundUp(capacity) - 1),
+                  m_slots(new Slot[m_mask + 1]) {}
+
+            SpscQueue(const SpscQueue&) = delete;
+            SpscQueue& operator=(const SpscQueue&) = delete;
+
+            ~SpscQueue() {
+                std::size_t head = m_head.load(std::memory_order_relaxed);
+                const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                for(; head != tail; ++head)
+                    slot(head)->~T();
+            }
+
+            std::size_t capacity() const {
+                return m_mask + 1;
+            }
+
+            /**
+               Вызывается только писателем
+            */
+            template <class TValue>
+            bool tryPush(TValue&& value) {
+                const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+                if(tail - m_cached_head == capacity()) {
+                    m_cached_head = m_head.load(std::memory_order_acquire);
+                    if(tail - m_cached_head == capacity())
+                        return false;
+                }
+
+                new (slot(tail)) T(std::forward<TValue>(value));
+                m_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+               Вызывается только читателем. Передаёт элемент в
+               func как rvalue и удаляет его из очереди.
+            */
+            template <class Func>
+            bool tryPop(Func&& func) {
+                const std::size_t head = m_head.load(std::memory_order_relaxed);
+                if(head == m_cached_tail) {
+                    m_cached_tail = m_tail.load(std::memory_order_acquire);
+                    if(head == m_cached_tail)
+                        return false;
+                }
+
+                T* value = slot(head);
+                func(std::move(*value));
+                value->~T();
+                m_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+               Писатель сообщает, что элементов больше не будет
+            */
+            void close() {
+                m_closed.store(true, std::memory_order_release);
+            }
+
+            bool closed() const {
+                return m_closed.load(std::memory_order_acquire);
+            }
+        };
+
+    } /* namespace details */
+
+} /* namespace pipeline */
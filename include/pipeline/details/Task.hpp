@@ -0,0 +1,221 @@
+/**
+   \file
+
+   Task<T> -- ленивая сопрограмма C++20 возвращающая T:
+   \code
+   Task<int> parse(EventLoop& loop, std::string path) {
+       std::string text = co_await loop.offload([path] { return read(path); });
+       co_return std::stoi(text);
+   }
+   \endcode
+
+   Сопрограмма начинает выполняться только когда её ждут через
+   co_await(или запускают в EventLoop), а по завершении сразу
+   передаёт управление ждущей сопрограмме без рекурсии на стеке.
+   Исключение из сопрограммы бросается из co_await.
+
+   Task только перемещается: ждать его можно один раз.
+
+   GCC 12 неправильно переносит в кадр сопрограммы временные
+   объекты из выражения с co_await: объект с указателем на
+   себя(например std::string с коротким значением) после этого
+   испорчен. Поэтому такие объекты стоит сначала сохранить в
+   переменную:
+   \code
+   auto read = [path] { return read_file(path); };
+   std::string text = co_await loop.offload(read);
+   \endcode
+
+   Только для C++20.
+*/
+
+#pragma once
+
+#include <pipeline/details/Maybe.hpp>
+
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#endif
+
+#ifdef __cpp_lib_coroutine
+
+namespace pipeline {
+
+    namespace details {
+
+        template <class T>
+        class Task;
+
+        /**
+           Общая часть promise_type для Task<T> и Task<void>
+        */
+        class TaskPromiseBase {
+            struct FinalAwaiter {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                template <class Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                    const std::coroutine_handle<> continuation = handle.promise().m_continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            std::exception_ptr m_error;
+        public:
+            /**
+               Сопрограмма, которая ждёт эту
+            */
+            std::coroutine_handle<> m_continuation;
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            FinalAwaiter final_suspend() noexcept {
+                return {};
+            }
+
+            void unhandled_exception() {
+                m_error = std::current_exception();
+            }
+
+            void rethrow() const {
+                if(m_error)
+                    std::rethrow_exception(m_error);
+            }
+        };
+
+        template <class T>
+        class TaskPromise final : public TaskPromiseBase {
+            std::optional<T> m_value;
+        public:
+            Task<T> get_return_object();
+
+            template <class U>
+            void return_value(U&& value) {
+                m_value.emplace(std::forward<U>(value));
+            }
+
+            T result() {
+                rethrow();
+                return std::move(*m_value);
+            }
+        };
+
+        template <>
+        class TaskPromise<void> final : public TaskPromiseBase {
+        public:
+            Task<void> get_return_object();
+
+            void return_void() {}
+
+            void result() {
+                rethrow();
+            }
+        };
+
+        template <class T>
+        class Task final {
+        public:
+            using promise_type = TaskPromise<T>;
+            using value_type = T;
+        private:
+            std::coroutine_handle<promise_type> m_handle;
+
+            class Awaiter {
+                std::coroutine_handle<promise_type> m_handle;
+            public:
+                explicit Awaiter(std::coroutine_handle<promise_type> handle)
+                    : m_handle(handle) {}
+
+                bool await_ready() const noexcept {
+                    return m_handle.done();
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+                    m_handle.promise().m_continuation = continuation;
+                    return m_handle;
+                }
+
+                T await_resume() {
+                    return m_handle.promise().result();
+                }
+            };
+        public:
+            explicit Task(std::coroutine_handle<promise_type> handle)
+                : m_handle(handle) {}
+
+            Task(Task&& other) noexcept
+                : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+            Task& operator=(Task&& other) noexcept {
+                if(this != &other) {
+                    if(m_handle)
+                        m_handle.destroy();
+                    m_handle = std::exchange(other.m_handle, nullptr);
+                }
+                return *this;
+            }
+
+            ~Task() {
+                if(m_handle)
+                    m_handle.destroy();
+            }
+
+            Awaiter operator co_await() && noexcept {
+                return Awaiter(m_handle);
+            }
+        };
+
+        template <class T>
+        Task<T> TaskPromise<T>::get_return_object() {
+            return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() {
+            return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+        }
+
+        /**
+           Тип который возвращает operator co_await у T, или
+           сам T если у него есть await_ready
+        */
+        template <class T, class = void>
+        struct AwaiterOf {};
+
+        template <class T>
+        struct AwaiterOf<T, VoidT<decltype(std::declval<T&>().await_ready())>> {
+            using type = T;
+        };
+
+        template <class T>
+        struct AwaiterOf<T, VoidT<decltype(std::declval<T>().operator co_await())>> {
+            using type = decltype(std::declval<T>().operator co_await());
+        };
+
+        template <class T, class = void>
+        struct IsAwaitable : std::false_type {};
+
+        template <class T>
+        struct IsAwaitable<T, VoidT<typename AwaiterOf<T>::type>> : std::true_type {};
+
+        /**
+           Тип значения co_await для T
+        */
+        template <class T>
+        using AwaitResult = decltype(std::declval<typename AwaiterOf<T>::type&>().await_resume());
+
+    } /* namespace details */
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_coroutine */
@@ -0,0 +1,304 @@
+/**
+   \file
+
+   ThreadPool -- пул потоков с кражей работы(work stealing).
+
+   У каждого рабочего потока своя очередь задач. Поток берёт
+   задачи с конца своей очереди, а когда она пуста -- крадёт
+   задачи с начала очередей других потоков. Так потоки почти
+   не мешают друг другу, а неравномерная нагрузка выравнивается.
+
+   Задача -- это не std::function, а пара указателей и диапазон
+   индексов, поэтому постановка задачи не аллоцирует память(кроме
+   роста самой очереди).
+
+   Поток ожидающий завершения parallelFor не простаивает, а
+   тоже выполняет задачи. Поэтому parallelFor можно вызывать и
+   изнутри задачи пула.
+*/
+
+#pragma once
+
+#include <pipeline/details/CacheLine.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        /**
+           Счётчик завершения группы задач
+        */
+        class Latch final {
+            std::mutex m_mutex;
+            std::condition_variable m_done;
+            std::size_t m_count;
+        public:
+            explicit Latch(std::size_t count)
+                : m_count(count) {}
+
+            void countDown() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if(--m_count == 0)
+                    m_done.notify_all();
+            }
+
+            bool done() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                return m_count == 0;
+            }
+
+            void wait() {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, [this] { return m_count == 0; });
+            }
+        };
+
+        class ThreadPool final {
+        public:
+            /**
+               Задача: вызов m_run(m_context, m_begin, m_end)
+            */
+            struct Task {
+                void (*m_run)(void*, std::size_t, std::size_t);
+                void* m_context;
+                std::size_t m_begin;
+                std::size_t m_end;
+            };
+
+            /**
+               Индекс возвращаемый currentWorker() для потоков
+               не принадлежащих пулу
+            */
+            static constexpr std::size_t no_worker = static_cast<std::size_t>(-1);
+        private:
+            struct alignas(cache_line_size) Worker {
+                std::mutex m_mutex;
+                std::deque<Task> m_tasks;
+            };
+
+            std::vector<AlignedPtr<Worker>> m_workers;
+            std::vector<std::thread> m_threads;
+
+            std::atomic<std::size_t> m_pending;
+            std::mutex m_sleep_mutex;
+            std::condition_variable m_wakeup;
+            bool m_stop;
+
+            static std::size_t& currentIndex() {
+                static thread_local std::size_t index = no_worker;
+                return index;
+            }
+
+            static const ThreadPool*& currentPool() {
+                static thread_local const ThreadPool* pool = nullptr;
+                return pool;
+            }
+
+            bool popOwn(std::size_t self, Task& task) {
+                Worker& worker = *m_workers[self];
+                std::lock_guard<std::mutex> lock(worker.m_mutex);
+                if(worker.m_tasks.empty())
+                    return false;
+                task = worker.m_tasks.back();
+                worker.m_tasks.pop_back();
+                return true;
+            }
+
+            bool steal(std::size_t victim, Task& task) {
+                Worker& worker = *m_workers[victim];
+                std::lock_guard<std::mutex> lock(worker.m_mutex);
+                if(worker.m_tasks.empty())
+                    return false;
+                task = worker.m_tasks.front();
+                worker.m_tasks.pop_front();
+                return true;
+            }
+
+            void loop(std::size_t self) {
+                currentIndex() = self;
+                currentPool() = this;
+
+                for(;;) {
+                    if(runOne())
+                        continue;
+
+                    std::unique_lock<std::mutex> lock(m_sleep_mutex);
+                    m_wakeup.wait(lock, [this] {
+                            return m_stop || m_pending.load() != 0;
+                        });
+                    if(m_stop && m_pending.load() == 0)
+                        return;
+                }
+            }
+        public:
+            explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency())
+                : m_pending(0),
+                  m_stop(false) {
+                threads = std::max<std::size_t>(threads, 1);
+
+                for(std::size_t i = 0; i < threads; ++i)
+                    m_workers.push_back(make_aligned<Worker>());
+                for(std::size_t i = 0; i < threads; ++i)
+                    m_threads.emplace_back([this, i] { loop(i); });
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            ~ThreadPool() {
+                {
+                    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+                    m_stop = true;
+                }
+                m_wakeup.notify_all();
+
+                for(auto& thread : m_threads)
+                    thread.join();
+            }
+
+            /**
+               Пул по умолчанию с числом потоков равным
+               числу ядер
+            */
+            static ThreadPool& instance() {
+                static ThreadPool pool;
+                return pool;
+            }
+
+            std::size_t size() const {
+                return m_workers.size();
+            }
+
+            /**
+               Индекс рабочего потока этого пула в котором
+               выполняется вызов, или no_worker
+            */
+            std::size_t currentWorker() const {
+                if(currentPool() != this)
+                    return no_worker;
+                return currentIndex();
+            }
+
+            /**
+               Ставит задачи в очереди рабочих потоков по кругу
+            */
+            void submit(const Task* tasks, std::size_t count) {
+                const std::size_t workers = m_workers.size();
+                const std::size_t self = currentWorker();
+                const std::size_t first = self == no_worker ? 0 : self;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+                    m_pending.fetch_add(count);
+                }
+
+                for(std::size_t i = 0; i < count; ++i) {
+                    Worker& worker = *m_workers[(first + i) % workers];
+                    std::lock_guard<std::mutex> lock(worker.m_mutex);
+                    worker.m_tasks.push_back(tasks[i]);
+                }
+                m_wakeup.notify_all();
+            }
+
+            /**
+               Выполняет одну задачу: свою, или украденную у
+               другого потока.
+
+               \return false если задач нет
+            */
+            bool runOne() {
+                const std::size_t workers = m_workers.size();
+                const std::size_t self = currentWorker();
+
+                Task task;
+                bool found = self != no_worker && popOwn(self, task);
+                const std::size_t start = self == no_worker ? 0 : self + 1;
+                for(std::size_t i = 0; !found && i < workers; ++i)
+                    found = steal((start + i) % workers, task);
+
+                if(!found)
+                    return false;
+
+                m_pending.fetch_sub(1);
+                task.m_run(task.m_context, task.m_begin, task.m_end);
+                return true;
+            }
+
+            /**
+               Вызывает body(begin, end) для кусков [0, size)
+               размером chunk и ждёт завершения всех кусков.
+
+               Если chunk равен 0, то он выбирается так, чтобы
+               на каждый поток пришлось несколько кусков.
+
+               Исключение брошенное из body передаётся в вызывающий
+               поток после завершения остальных кусков.
+            */
+            template <class Body>
+            void parallelFor(std::size_t size, std::size_t chunk, Body& body) {
+                if(size == 0)
+                    return;
+                if(chunk == 0)
+                    chunk = std::max<std::size_t>(size / (m_workers.size() * 4), 1);
+
+                struct Batch {
+                    Body* m_body;
+                    Latch m_latch;
+                    std::mutex m_error_mutex;
+                    std::exception_ptr m_error;
+
+                    Batch(Body* body, std::size_t count)
+                        : m_body(body),
+                          m_latch(count) {}
+
+                    static void run(void* context, std::size_t begin, std::size_t end) {
+                        Batch& batch = *static_cast<Batch*>(context);
+#ifdef __cpp_exceptions
+                        try {
+                            (*batch.m_body)(begin, end);
+                        } catch(...) {
+                            std::lock_guard<std::mutex> lock(batch.m_error_mutex);
+                            if(!batch.m_error)
+                                batch.m_error = std::current_exception();
+                        }
+#else
+                        (*batch.m_body)(begin, end);
+#endif /* __cpp_exceptions */
+                        batch.m_latch.countDown();
+                    }
+                };
+
+                const std::size_t count = (size + chunk - 1) / chunk;
+                Batch batch(&body, count);
+
+                std::vector<Task> tasks;
+                tasks.reserve(count);
+                for(std::size_t begin = 0; begin < size; begin += chunk)
+                    tasks.push_back(Task{&Batch::run, &batch, begin, std::min(begin + chunk, size)});
+                submit(tasks.data(), tasks.size());
+
+                while(!batch.m_latch.done())
+                    if(!runOne())
+                        batch.m_latch.wait();
+
+#ifdef __cpp_exceptions
+                if(batch.m_error)
+                    std::rethrow_exception(batch.m_error);
+#endif /* __cpp_exceptions */
+            }
+        };
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -0,0 +1,253 @@
+/**
+   \file
+
+   Trace -- запись событий начала и конца вызовов стадий для
+   просмотра в chrome://tracing или Perfetto.
+
+   Каждый поток пишет события в свой буфер без блокировок: буфер
+   -- это список блоков, писатель заполняет последний блок, а
+   flush читает и освобождает заполненные. Поэтому flush можно
+   вызывать пока pipeline работает.
+
+   События пишут стадии помеченные instrument(см. Instrument.hpp),
+   и только между start_trace() и stop_trace().
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pipeline {
+
+    namespace details {
+
+        class Trace final {
+        public:
+            struct Event {
+                std::uint64_t m_time;
+                std::uint64_t m_size;
+                std::uint32_t m_stage;
+                char m_phase;
+            };
+
+            static constexpr std::size_t chunk_size = 4096;
+
+            struct Chunk {
+                Event m_events[chunk_size];
+                std::atomic<std::size_t> m_count{0};
+                std::atomic<Chunk*> m_next{nullptr};
+            };
+
+            /**
+               Буфер событий одного потока. push вызывает только
+               поток-владелец, drain -- только flush под мьютексом.
+            */
+            class Buffer final {
+                Chunk* m_head;
+                std::size_t m_read;
+                Chunk* m_tail;
+                std::atomic<bool> m_finished;
+                const std::uint32_t m_thread;
+            public:
+                explicit Buffer(std::uint32_t thread)
+                    : m_head(new Chunk),
+                      m_read(0),
+                      m_tail(m_head),
+                      m_finished(false),
+                      m_thread(thread) {}
+
+                Buffer(const Buffer&) = delete;
+                Buffer& operator=(const Buffer&) = delete;
+
+                ~Buffer() {
+                    while(m_head) {
+                        Chunk* next = m_head->m_next.load(std::memory_order_relaxed);
+                        delete m_head;
+                        m_head = next;
+                    }
+                }
+
+                std::uint32_t thread() const {
+                    return m_thread;
+                }
+
+                void push(const Event& event) {
+                    std::size_t count = m_tail->m_count.load(std::memory_order_relaxed);
+                    if(count == chunk_size) {
+                        Chunk* next = new Chunk;
+                        m_tail->m_next.store(next, std::memory_order_release);
+                        m_tail = next;
+                        count = 0;
+                    }
+                    m_tail->m_events[count] = event;
+                    m_tail->m_count.store(count + 1, std::memory_order_release);
+                }
+
+                /**
+                   Поток-владелец завершился, событий больше не будет
+                */
+                void finish() {
+                    m_finished.store(true, std::memory_order_release);
+                }
+
+                /**
+                   Передаёт в func все опубликованные события
+                   которые ещё не были прочитаны.
+
+                   \return true если поток завершился и все его
+                   события прочитаны
+                */
+                template <class Func>
+                bool drain(Func&& func) {
+                    const bool finished = m_finished.load(std::memory_order_acquire);
+                    for(;;) {
+                        // next читается до count: если следующий блок
+                        // уже есть, то этот блок заполнен до конца
+                        Chunk* next = m_head->m_next.load(std::memory_order_acquire);
+                        const std::size_t count = m_head->m_count.load(std::memory_order_acquire);
+                        for(; m_read < count; ++m_read)
+                            func(m_head->m_events[m_read]);
+                        if(!next)
+                            return finished;
+
+                        delete m_head;
+                        m_head = next;
+                        m_read = 0;
+                    }
+                }
+            };
+        private:
+            std::atomic<bool> m_enabled;
+            std::mutex m_mutex;
+            std::vector<std::shared_ptr<Buffer>> m_buffers;
+            std::uint32_t m_next_thread;
+            const std::chrono::steady_clock::time_point m_epoch;
+
+            Trace()
+                : m_enabled(false),
+                  m_next_thread(0),
+                  m_epoch(std::chrono::steady_clock::now()) {}
+
+            std::shared_ptr<Buffer> attach() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_buffers.push_back(std::make_shared<Buffer>(m_next_thread++));
+                return m_buffers.back();
+            }
+
+            static Buffer& local() {
+                struct Owner {
+                    std::shared_ptr<Buffer> m_buffer;
+
+                    Owner()
+                        : m_buffer(instance().attach()) {}
+
+                    ~Owner() {
+                        m_buffer->finish();
+                    }
+                };
+
+                static thread_local Owner owner;
+                return *owner.m_buffer;
+            }
+
+            static void writeString(std::ostream& out, const std::string& value) {
+                out << '"';
+                for(char c : value) {
+                    if(c == '"' || c == '\\')
+                        out << '\\' << c;
+                    else if(static_cast<unsigned char>(c) < 0x20)
+                        out << ' ';
+                    else
+                        out << c;
+                }
+                out << '"';
+            }
+        public:
+            static Trace& instance() {
+                static Trace trace;
+                return trace;
+            }
+
+            static bool enabled() {
+                return instance().m_enabled.load(std::memory_order_relaxed);
+            }
+
+            void start() {
+                m_enabled.store(true);
+            }
+
+            void stop() {
+                m_enabled.store(false);
+            }
+
+            /**
+               Время в наносекундах от создания Trace
+            */
+            std::uint64_t now() const {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - m_epoch).count();
+            }
+
+            /**
+               Записывает событие в буфер текущего потока.
+
+               \param phase 'B' -- начало вызова, 'E' -- конец
+            */
+            void record(std::uint32_t stage, char phase, std::uint64_t size) {
+                local().push(Event{now(), size, stage, phase});
+            }
+
+            /**
+               Пишет в path все события записанные с прошлого
+               flush в формате Chrome trace JSON.
+
+               \param labels метки стадий по номерам
+               \return false если файл не удалось записать
+            */
+            bool flush(const std::string& path, const std::vector<std::string>& labels) {
+                std::ofstream out(path);
+                if(!out)
+                    return false;
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                out << "{\"traceEvents\":[";
+                bool first = true;
+                for(auto buffer = m_buffers.begin(); buffer != m_buffers.end(); ) {
+                    const std::uint32_t thread = (*buffer)->thread();
+                    const bool done = (*buffer)->drain([&](const Event& event) {
+                            out << (first ? "\n" : ",\n") << "{\"name\":";
+                            writeString(out, event.m_stage < labels.size() ? labels[event.m_stage] : "?");
+                            out << ",\"ph\":\"" << event.m_phase << '"'
+                                << ",\"ts\":" << event.m_time / 1000 << '.'
+                                << static_cast<char>('0' + event.m_time / 100 % 10)
+                                << static_cast<char>('0' + event.m_time / 10 % 10)
+                                << static_cast<char>('0' + event.m_time % 10)
+                                << ",\"pid\":1,\"tid\":" << thread
+                                << ",\"args\":{\"size\":" << event.m_size << "}}";
+                            first = false;
+                        });
+
+                    if(done)
+                        buffer = m_buffers.erase(buffer);
+                    else
+                        ++buffer;
+                }
+                out << "\n]}\n";
+
+                out.flush();
+                return static_cast<bool>(out);
+            }
+        };
+
+    } /* namespace details */
+
+} /* namespace pipeline */
@@ -4,6 +4,7 @@
 #include <pipeline/details/JustReturn.hpp>
 
 #include <tuple>
+#include <type_traits>
 
 namespace pipeline {
 
@@ -24,7 +25,7 @@ namespace pipeline {
                         Seq<S...>,
                         Args&&... args)
                 JUST_RETURN(
-                    func(std::forward<Args>(args)...,
+                    std::forward<Func>(func)(std::forward<Args>(args)...,
                          std::get<S>(std::forward<Tuple>(tuple))...)
                     );
         public:
@@ -50,19 +51,22 @@ namespace pipeline {
             /**
                Делает вызов: func(args..., tuple...);
 
-               Для lvalue std::tuple.
+               Для lvalue std::tuple, в том числе const. Одна
+               перегрузка на оба случая: иначе для не const
+               tuple подставлялась бы и const версия, а с ней
+               тело функции с выводимым типом результата.
             */
             template <class... Args,
                       class Func,
-                      class... TArgs>
+                      class Tuple>
             static
             auto call(Func&& func,
-                      std::tuple<TArgs...>& tuple,
+                      Tuple& tuple,
                       Args&&... args)
                 JUST_RETURN(
                     helper(std::forward<Func>(func),
                            tuple,
-                           GenSeq_t<sizeof...(TArgs)>(),
+                           GenSeq_t<std::tuple_size<std::remove_const_t<Tuple>>::value>(),
                            std::forward<Args>(args)...)
                     );
         };
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <pipeline/details/Expected.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::Expected;
+    using pipeline::details::Unexpected;
+    using pipeline::details::make_unexpected;
+
+} /* namespace pipeline */
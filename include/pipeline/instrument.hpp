@@ -0,0 +1,15 @@
+#pragma once
+
+#include <pipeline/details/Instrument.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::StageStats;
+    using pipeline::details::instrument;
+    using pipeline::details::stage_stats;
+    using pipeline::details::reset_stage_stats;
+    using pipeline::details::start_trace;
+    using pipeline::details::stop_trace;
+    using pipeline::details::flush_trace;
+
+} /* namespace pipeline */
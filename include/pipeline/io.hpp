@@ -0,0 +1,30 @@
+#pragma once
+
+#include <pipeline/details/FileSink.hpp>
+#include <pipeline/details/MappedFile.hpp>
+#include <pipeline/details/Records.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::FileSinkOptions;
+    using pipeline::details::FileSinkStats;
+    using pipeline::details::file_sink;
+    using pipeline::details::flush_sink;
+    using pipeline::details::sink_stats;
+
+} /* namespace pipeline */
+
+#ifdef __cpp_lib_string_view
+
+namespace pipeline {
+
+    using pipeline::details::MappedFile;
+    using pipeline::details::map_file;
+    using pipeline::details::map_files;
+    using pipeline::details::records;
+    using pipeline::details::fixed_records;
+    using pipeline::details::split;
+
+} /* namespace pipeline */
+
+#endif /* __cpp_lib_string_view */
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <pipeline/details/Parallel.hpp>
+#include <pipeline/details/Pipelined.hpp>
+#include <pipeline/details/Shard.hpp>
+#include <pipeline/details/ThreadPool.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::ThreadPool;
+    using pipeline::details::par_map;
+    using pipeline::details::par_fold;
+    using pipeline::details::FoldOrder;
+    using pipeline::details::pipelined;
+    using pipeline::details::pipelined_with;
+    using pipeline::details::shard_by;
+
+} /* namespace pipeline */
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pipeline/details/Batch.hpp>
+#include <pipeline/details/Generator.hpp>
+#include <pipeline/details/Range.hpp>
+#include <pipeline/details/Span.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::map;
+    using pipeline::details::filter;
+    using pipeline::details::take;
+    using pipeline::details::drop;
+    using pipeline::details::to_vector;
+
+    using pipeline::details::Span;
+    using pipeline::details::batch;
+    using pipeline::details::map_batch;
+    using pipeline::details::unbatch;
+
+#ifdef __cpp_lib_coroutine
+    using pipeline::details::Generator;
+#endif
+
+} /* namespace pipeline */
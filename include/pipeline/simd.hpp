@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pipeline/details/Simd.hpp>
+#include <pipeline/details/SimdLevel.hpp>
+#include <pipeline/details/SimdPack.hpp>
+
+namespace pipeline {
+
+    using pipeline::details::Pack;
+    using pipeline::details::Mask;
+    using pipeline::details::pack_cast;
+    using pipeline::details::SimdLevel;
+    using pipeline::details::best_simd_level;
+    using pipeline::details::simd_map;
+    using pipeline::details::simd_filter;
+
+} /* namespace pipeline */
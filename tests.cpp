@@ -1,13 +1,42 @@
 
-#include <pipeline/pipeline.hpp>
-#include <pipeline/args.hpp>
-
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE pipeline_tests
 
+// boost подключается до pipeline, так как макрос A из args.hpp
+// конфликтует с именами шаблонных параметров внутри boost
 #include <boost/test/unit_test.hpp>
 #include <type_traits>
 
+#include <pipeline/pipeline.hpp>
+#include <pipeline/any.hpp>
+#include <pipeline/args.hpp>
+#include <pipeline/arena.hpp>
+#include <pipeline/async.hpp>
+#include <pipeline/cache.hpp>
+#include <pipeline/expected.hpp>
+#include <pipeline/instrument.hpp>
+#include <pipeline/io.hpp>
+#include <pipeline/parallel.hpp>
+#include <pipeline/range.hpp>
+#include <pipeline/simd.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 using namespace pipeline;
 
 struct Data {
@@ -297,6 +326,20 @@ BOOST_AUTO_TEST_CASE(test_args_with_1_arg) {
     BOOST_CHECK_EQUAL(Data::m_move_constructor, 0);
 }
 
+int sum10(int a0, int a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8, int a9) {
+    return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7 + a8 + a9;
+}
+
+BOOST_AUTO_TEST_CASE(test_args_many) {
+    using pipeline::details::GenSeq_t;
+    using pipeline::details::Seq;
+
+    BOOST_CHECK((std::is_same<GenSeq_t<0>, Seq<>>::value));
+    BOOST_CHECK((std::is_same<GenSeq_t<3>, Seq<0, 1, 2>>::value));
+
+    BOOST_CHECK_EQUAL(1 | sum10 A(2, 3, 4, 5, 6, 7, 8, 9, 10), 55);
+}
+
 BOOST_AUTO_TEST_CASE(test_template_func) {
     Data::clear();
 
@@ -329,3 +372,1449 @@ BOOST_AUTO_TEST_CASE(test_template_func) {
     BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
     BOOST_CHECK_EQUAL(Data::m_move_constructor, 0);
 }
+
+BOOST_AUTO_TEST_CASE(test_compose_pipe_ops) {
+    Data::clear();
+
+    Data mut_data;
+
+    auto chain = pipe_op_factory(&Data::mutWithArg)(2)
+        | pipe_op_factory(&Data::mutWithArg)(3)
+        | pipe_op_factory(&Data::constWithArg)(4);
+
+    Data::m_mut_call = 0;
+    Data::m_const_call = 0;
+    Data::m_arg_value = 0;
+    const Data& result = chain(mut_data);
+    BOOST_CHECK_EQUAL(&result, &mut_data);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 2);
+    BOOST_CHECK_EQUAL(Data::m_const_call, 1);
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 4);
+
+    Data::m_mut_call = 0;
+    Data::m_const_call = 0;
+    const Data& piped = mut_data | chain;
+    BOOST_CHECK_EQUAL(&piped, &mut_data);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 2);
+    BOOST_CHECK_EQUAL(Data::m_const_call, 1);
+
+    Data::m_mut_call = 0;
+    Data::m_const_call = 0;
+    mut_data | (chain | pipe_op(&Data::constWithoutArgs));
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 2);
+    BOOST_CHECK_EQUAL(Data::m_const_call, 2);
+
+    BOOST_CHECK_EQUAL(Data::m_def_constructor, 1);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
+    BOOST_CHECK_EQUAL(Data::m_move_constructor, 0);
+}
+
+int add_one(int n) {
+    return n + 1;
+}
+
+int twice(int n) {
+    return n * 2;
+}
+
+int mul3(int a, int b, int c) {
+    return a * b * c;
+}
+
+BOOST_AUTO_TEST_CASE(test_compose_associativity) {
+    auto inc = pipe_op(add_one);
+    const auto dbl = pipe_op(twice);
+
+    auto left = (inc | dbl) | inc;
+    auto right = inc | (dbl | inc);
+
+    BOOST_CHECK((std::is_same<decltype(left), decltype(right)>::value));
+
+    BOOST_CHECK_EQUAL(left(1), 5);
+    BOOST_CHECK_EQUAL(right(1), 5);
+    BOOST_CHECK_EQUAL(1 | left, 1 | inc | dbl | inc);
+    BOOST_CHECK_EQUAL(1 | (inc | dbl) | (inc | dbl), 10);
+}
+
+BOOST_AUTO_TEST_CASE(test_compose_same_empty_stage) {
+    // вложенные композиции с одним и тем же пустым типом
+    auto inc = [](int x) { return x + 1; };
+    auto three = pipe_op(inc) | pipe_op(inc) | pipe_op(inc);
+    BOOST_CHECK_EQUAL(1 | three, 4);
+
+    auto add = pipe_op<decltype(&add_one), &add_one>();
+    auto dbl = pipe_op<decltype(&twice), &twice>();
+    BOOST_CHECK_EQUAL(1 | (add | add | dbl), 6);
+    BOOST_CHECK_EQUAL(1 | (add | add | add | add), 5);
+}
+
+bool is_odd(int n) {
+    return n % 2 != 0;
+}
+
+std::vector<int> numbers(int count) {
+    std::vector<int> result;
+    for(int i = 0; i < count; ++i)
+        result.push_back(i);
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(test_range_stages) {
+    const std::vector<int> src = numbers(10);
+
+    BOOST_CHECK((src | map(twice) | to_vector) == std::vector<int>({0, 2, 4, 6, 8, 10, 12, 14, 16, 18}));
+    BOOST_CHECK((src | filter(is_odd) | to_vector) == std::vector<int>({1, 3, 5, 7, 9}));
+    BOOST_CHECK((src | drop(7) | to_vector) == std::vector<int>({7, 8, 9}));
+    BOOST_CHECK((src | take(3) | to_vector) == std::vector<int>({0, 1, 2}));
+    BOOST_CHECK((src | take(0) | to_vector).empty());
+    BOOST_CHECK((src | take(20) | to_vector) == src);
+
+    BOOST_CHECK((src | filter(is_odd) | map(add_one) | drop(1) | take(2) | to_vector)
+                == std::vector<int>({4, 6}));
+
+    auto stages = filter(is_odd) | map(twice) | take(2) | to_vector;
+    BOOST_CHECK((src | stages) == std::vector<int>({2, 6}));
+    BOOST_CHECK((numbers(4) | stages) == std::vector<int>({2, 6}));
+
+    // rvalue источник хранится внутри представления
+    auto view = numbers(5) | map(add_one);
+    BOOST_CHECK((view | take(2) | to_vector) == std::vector<int>({1, 2}));
+    BOOST_CHECK((view | to_vector) == std::vector<int>({1, 2, 3, 4, 5}));
+}
+
+BOOST_AUTO_TEST_CASE(test_range_take_stops_early) {
+    const std::vector<int> src = numbers(1000);
+
+    int calls = 0;
+    auto counted = [&calls](int n) {
+        ++calls;
+        return n;
+    };
+
+    auto result = src | map(counted) | filter(is_odd) | take(3) | to_vector;
+    BOOST_CHECK(result == std::vector<int>({1, 3, 5}));
+    BOOST_CHECK_EQUAL(calls, 6);
+}
+
+BOOST_AUTO_TEST_CASE(test_range_without_copies) {
+    Data::clear();
+
+    std::vector<Data> src(4);
+    BOOST_CHECK_EQUAL(Data::m_def_constructor, 4);
+
+    Data::m_arg_value = 0;
+    auto view = src | map(pipe_op_factory(&Data::mutWithArg)(5).m_func) | take(3);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 0);
+
+    Data::m_mut_call = 0;
+    int count = 0;
+    view.forEach([&count](Data& d) {
+            d.constWithoutArgs();
+            ++count;
+            return true;
+        });
+    BOOST_CHECK_EQUAL(count, 3);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 3);
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 5);
+
+    BOOST_CHECK_EQUAL(Data::m_def_constructor, 4);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
+    BOOST_CHECK_EQUAL(Data::m_move_constructor, 0);
+
+    auto result = view | to_vector;
+    BOOST_CHECK_EQUAL(result.size(), 3U);
+}
+
+struct Square {
+    long long operator()(int n) const {
+        return static_cast<long long>(n) * n;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_make_aligned) {
+    using pipeline::details::cache_line_size;
+    using pipeline::details::make_aligned;
+
+    struct alignas(cache_line_size) Padded {
+        int m_value;
+    };
+
+    for(int i = 0; i < 16; ++i) {
+        auto padded = make_aligned<Padded>(Padded{i});
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(padded.get()) % cache_line_size, 0);
+        BOOST_CHECK_EQUAL(padded->m_value, i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_par_map) {
+    ThreadPool pool(4);
+
+    const std::vector<int> src = numbers(1000);
+
+    std::vector<long long> expected;
+    for(int n : src)
+        expected.push_back(static_cast<long long>(n) * n);
+
+    BOOST_CHECK((src | par_map(pool, Square(), 7)) == expected);
+    BOOST_CHECK((src | par_map(pool, Square(), 1)) == expected);
+    BOOST_CHECK((src | par_map(pool, Square(), 5000)) == expected);
+    BOOST_CHECK((src | par_map(pool, Square())) == expected);
+    BOOST_CHECK((src | par_map(Square(), 64)) == expected);
+
+    BOOST_CHECK((std::vector<int>() | par_map(pool, Square())).empty());
+
+    auto stages = par_map(pool, twice, 16) | map(add_one) | take(3) | to_vector;
+    BOOST_CHECK((src | stages) == std::vector<int>({1, 3, 5}));
+}
+
+struct Record {
+    int m_id;
+
+    int id() const {
+        return m_id;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_par_map_method_and_nested) {
+    ThreadPool pool(3);
+
+    std::vector<Record> records;
+    for(int i = 0; i < 10; ++i)
+        records.push_back(Record{i * 10});
+
+    auto ids = records | par_map(pool, &Record::id, 3);
+    for(int i = 0; i < 10; ++i)
+        BOOST_CHECK_EQUAL(ids[i], i * 10);
+
+    // par_map внутри задачи пула не должен приводить к взаимной блокировке
+    auto inner = par_map(pool, twice, 2);
+    auto outer = [&inner](int n) {
+        auto doubled = numbers(n) | inner;
+        int sum = 0;
+        for(int d : doubled)
+            sum += d;
+        return sum;
+    };
+
+    auto sums = numbers(20) | par_map(pool, outer, 1);
+    for(int n = 0; n < 20; ++n)
+        BOOST_CHECK_EQUAL(sums[n], n * (n - 1));
+}
+
+int throw_on_five(int n) {
+    if(n == 5)
+        throw std::runtime_error("five");
+    return n;
+}
+
+BOOST_AUTO_TEST_CASE(test_par_map_exception) {
+    ThreadPool pool(2);
+
+    BOOST_CHECK_THROW(numbers(100) | par_map(pool, throw_on_five, 3), std::runtime_error);
+    BOOST_CHECK((numbers(5) | par_map(pool, throw_on_five)) == numbers(5));
+}
+
+std::vector<int> count_digit(std::vector<int> histogram, int n) {
+    ++histogram[n % 10];
+    return histogram;
+}
+
+std::vector<int> add_histograms(std::vector<int> lhs, const std::vector<int>& rhs) {
+    for(std::size_t i = 0; i < lhs.size(); ++i)
+        lhs[i] += rhs[i];
+    return lhs;
+}
+
+BOOST_AUTO_TEST_CASE(test_par_fold) {
+    ThreadPool pool(4);
+
+    const std::vector<int> src = numbers(1000);
+    auto sum = [](long long acc, long long n) { return acc + n; };
+
+    BOOST_CHECK_EQUAL(src | par_fold(pool, 0LL, sum, sum), 499500);
+    BOOST_CHECK_EQUAL(src | par_fold(pool, 0LL, sum, sum, FoldOrder::any, 1), 499500);
+    BOOST_CHECK_EQUAL(src | par_fold(pool, 0LL, sum, sum, FoldOrder::ordered, 7), 499500);
+    BOOST_CHECK_EQUAL(src | par_fold(0LL, sum, sum), 499500);
+    BOOST_CHECK_EQUAL(std::vector<int>() | par_fold(pool, 5LL, sum, sum), 5);
+
+    // после par_map, с объединением по порядку
+    BOOST_CHECK_EQUAL(src | par_map(pool, Square(), 16) | par_fold(pool, 0LL, sum, sum, FoldOrder::ordered), 332833500);
+
+    auto histogram = src | par_fold(pool, std::vector<int>(10), count_digit, add_histograms, FoldOrder::any, 9);
+    BOOST_CHECK((histogram == std::vector<int>(10, 100)));
+
+    // порядок объединения важен: конкатенация строк
+    std::vector<std::string> letters;
+    for(char c = 'a'; c <= 'z'; ++c)
+        letters.push_back(std::string(1, c));
+    auto concat = [](std::string lhs, const std::string& rhs) { return lhs + rhs; };
+    BOOST_CHECK_EQUAL(letters | par_fold(pool, std::string(), concat, concat, FoldOrder::ordered, 3),
+                      "abcdefghijklmnopqrstuvwxyz");
+
+    // с ordered результат для чисел с плавающей точкой не меняется
+    std::vector<double> values;
+    for(int i = 0; i < 10000; ++i)
+        values.push_back(1.0 / (i + 1));
+    auto fsum = [](double acc, double x) { return acc + x; };
+    const double first = values | par_fold(pool, 0.0, fsum, fsum, FoldOrder::ordered, 100);
+    for(int i = 0; i < 10; ++i)
+        BOOST_CHECK_EQUAL(values | par_fold(pool, 0.0, fsum, fsum, FoldOrder::ordered, 100), first);
+
+    auto throw_fold = [](int acc, int n) { return acc + throw_on_five(n); };
+    BOOST_CHECK_THROW(numbers(100) | par_fold(pool, 0, throw_fold, throw_fold), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipelined) {
+    const std::vector<int> src = numbers(5000);
+
+    auto inc = pipe_op(add_one);
+    auto dbl = pipe_op(twice);
+
+    auto result = src | pipelined(inc, dbl, inc);
+    BOOST_CHECK_EQUAL(result.size(), src.size());
+    for(int n : src)
+        BOOST_CHECK_EQUAL(result[n], (n + 1) * 2 + 1);
+
+    // очередь ёмкостью 1 заставляет стадии постоянно ждать друг друга
+    BOOST_CHECK((src | pipelined_with(1, dbl, inc)) == (src | map(twice) | map(add_one) | to_vector));
+    BOOST_CHECK((src | filter(is_odd) | take(3) | pipelined(dbl)) == std::vector<int>({2, 6, 10}));
+    BOOST_CHECK((std::vector<int>() | pipelined(inc, dbl)).empty());
+
+    // у каждой стадии своё состояние, стадии могут менять тип значения
+    int total = 0;
+    auto sum = [&total](long long n) { total += static_cast<int>(n); };
+    numbers(100) | pipelined([](int n) { return static_cast<long long>(n); }, sum);
+    BOOST_CHECK_EQUAL(total, 4950);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipelined_exception) {
+    BOOST_CHECK_THROW(numbers(10000) | pipelined_with(4, pipe_op(throw_on_five), pipe_op(twice)),
+                      std::runtime_error);
+    BOOST_CHECK_THROW(numbers(10000) | pipelined_with(4, pipe_op(add_one), pipe_op(throw_on_five)),
+                      std::runtime_error);
+}
+
+struct Click {
+    int m_user;
+    int m_time;
+};
+
+BOOST_AUTO_TEST_CASE(test_shard_by) {
+    std::vector<Click> clicks;
+    for(int i = 0; i < 3000; ++i)
+        clicks.push_back(Click{i * 7 % 50, i});
+
+    // номер клика пользователя: состояние каждой копии без мьютекса
+    auto count = [seen = std::unordered_map<int, int>()](const Click& click) mutable {
+        return std::make_pair(click.m_user, ++seen[click.m_user]);
+    };
+    auto numbered = clicks | shard_by(&Click::m_user, 4, count);
+    BOOST_REQUIRE_EQUAL(numbered.size(), clicks.size());
+
+    std::unordered_map<int, int> last;
+    for(const auto& pair : numbered) {
+        BOOST_CHECK_EQUAL(pair.second, last[pair.first] + 1);
+        last[pair.first] = pair.second;
+    }
+    BOOST_CHECK_EQUAL(last.size(), 50);
+    BOOST_CHECK_EQUAL(last[0], 60);
+
+    // один пользователь -- один поток, порядок внутри пользователя сохраняется
+    // BOOST_CHECK не потокобезопасен, поэтому потоки пишут каждый в свои ячейки
+    std::vector<std::pair<int, std::thread::id>> threads(clicks.size());
+    std::vector<char> reordered(clicks.size());
+    auto record = [&threads, &reordered, previous = std::unordered_map<int, int>()](Click click) mutable {
+        auto found = previous.find(click.m_user);
+        reordered[click.m_time] = found != previous.end() && found->second > click.m_time;
+        previous[click.m_user] = click.m_time;
+        threads[click.m_time] = std::make_pair(click.m_user, std::this_thread::get_id());
+    };
+    clicks | shard_by([](const Click& click) { return click.m_user; }, 3, record, 8);
+    std::unordered_map<int, std::thread::id> user_threads;
+    for(const auto& thread : threads)
+        BOOST_CHECK(user_threads.emplace(thread).first->second == thread.second);
+    BOOST_CHECK(std::count(reordered.begin(), reordered.end(), 1) == 0);
+
+    // метод как ключ, downstream -- цепочка стадий
+    std::vector<Record> records;
+    for(int i = 0; i < 100; ++i)
+        records.push_back(Record{i % 10});
+    auto unique = [seen = std::unordered_set<int>()](int id) mutable { return seen.insert(id).second ? 1 : 0; };
+    auto fresh = records | shard_by(&Record::id, 2, pipe_op(&Record::id) | pipe_op(unique));
+    BOOST_CHECK_EQUAL(std::accumulate(fresh.begin(), fresh.end(), 0), 10);
+
+    BOOST_CHECK((std::vector<Click>() | shard_by(&Click::m_user, 4, count)).empty());
+    BOOST_CHECK_THROW(numbers(10000) | shard_by(twice, 3, pipe_op(throw_on_five), 4), std::runtime_error);
+}
+
+struct BatchSum {
+    static int m_batch_calls;
+    static int m_item_calls;
+
+    int operator()(int n) const {
+        ++m_item_calls;
+        return n;
+    }
+
+    int operator()(Span<const int> batch) const {
+        ++m_batch_calls;
+        int sum = 0;
+        for(int n : batch)
+            sum += n;
+        return sum;
+    }
+};
+
+int BatchSum::m_batch_calls;
+int BatchSum::m_item_calls;
+
+BOOST_AUTO_TEST_CASE(test_batch) {
+    const std::vector<int> src = numbers(10);
+
+    std::vector<std::size_t> sizes;
+    std::vector<const int*> buffers;
+    src | batch(4) | map_batch([&sizes, &buffers](Span<int> b) {
+            sizes.push_back(b.size());
+            buffers.push_back(b.data());
+            return 0;
+        }) | to_vector;
+    BOOST_CHECK(sizes == std::vector<std::size_t>({4, 4, 2}));
+    // буфер переиспользуется для всех пакетов
+    BOOST_CHECK(buffers[0] == buffers[1] && buffers[1] == buffers[2]);
+
+    BOOST_CHECK((src | batch(3) | unbatch | to_vector) == src);
+    BOOST_CHECK((src | batch(3) | unbatch | take(4) | to_vector) == numbers(4));
+    BOOST_CHECK((src | batch(100) | unbatch | to_vector) == src);
+    BOOST_CHECK((std::vector<int>() | batch(3) | unbatch | to_vector).empty());
+
+    // пакеты ссылаются на общий буфер, собирать их нельзя
+    using pipeline::details::IsCallable;
+    using Batched = decltype(src | batch(3));
+    using Mapped = decltype(src | batch(3) | map_batch(twice));
+    BOOST_CHECK((!IsCallable<decltype(to_vector)&, Batched>::value));
+    BOOST_CHECK((!IsCallable<decltype(to_vector)&, Mapped>::value));
+    BOOST_CHECK((IsCallable<decltype(to_vector)&, std::vector<Span<int>>>::value));
+}
+
+BOOST_AUTO_TEST_CASE(test_map_batch_dispatch) {
+    const std::vector<int> src = numbers(10);
+
+    BatchSum::m_batch_calls = 0;
+    BatchSum::m_item_calls = 0;
+    BOOST_CHECK((src | batch(4) | map_batch(BatchSum()) | to_vector) == std::vector<int>({6, 22, 17}));
+    BOOST_CHECK_EQUAL(BatchSum::m_batch_calls, 3);
+    BOOST_CHECK_EQUAL(BatchSum::m_item_calls, 0);
+
+    // у функции нет пакетной перегрузки: вызов для каждого элемента
+    BOOST_CHECK((src | batch(4) | map_batch(twice) | unbatch | to_vector)
+                == (src | map(twice) | to_vector));
+
+    auto stages = batch(3) | map_batch(add_one) | unbatch | filter(is_odd) | to_vector;
+    BOOST_CHECK((src | stages) == std::vector<int>({1, 3, 5, 7, 9}));
+}
+
+int negate_noexcept(int n) noexcept {
+    return -n;
+}
+
+/**
+   Методы с noexcept и ссылочными квалификаторами
+*/
+struct Qualified {
+    int m_value;
+
+    int get() const noexcept {
+        return m_value;
+    }
+
+    int lvalue() & {
+        return m_value;
+    }
+
+    int rvalue() && {
+        return -m_value;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_static_callable) {
+    Data::clear();
+
+    Data mut_data;
+    const Data const_data;
+
+    auto func_f = pipe_op<decltype(&func_const), &func_const>();
+    auto templ_f = pipe_op<decltype(&templ_func<const Data>), &templ_func<const Data>>();
+    auto const_meth_f = pipe_op<decltype(&Data::constWithoutArgs), &Data::constWithoutArgs>();
+    auto mut_meth_f = pipe_op_factory<decltype(&Data::mutWithArg), &Data::mutWithArg>();
+
+    m_func_call = 0;
+    mut_data | func_f;
+    const_data | templ_f;
+    BOOST_CHECK_EQUAL(m_func_call, 2);
+
+    Data::m_const_call = 0;
+    mut_data | const_meth_f;
+    const_data | const_meth_f;
+    BOOST_CHECK_EQUAL(Data::m_const_call, 2);
+
+    Data::m_mut_call = 0;
+    Data::m_arg_value = 0;
+    Data& result = mut_data | mut_meth_f(3);
+    BOOST_CHECK_EQUAL(&result, &mut_data);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 1);
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 3);
+
+    /// не должны компилироваться
+    // const_data | mut_meth_f(3);
+
+    auto negate_f = pipe_op<decltype(&negate_noexcept), &negate_noexcept>();
+    auto get_f = pipe_op<decltype(&Qualified::get), &Qualified::get>();
+    auto lvalue_f = pipe_op<decltype(&Qualified::lvalue), &Qualified::lvalue>();
+    auto rvalue_f = pipe_op<decltype(&Qualified::rvalue), &Qualified::rvalue>();
+    Qualified qualified{3};
+    BOOST_CHECK_EQUAL(3 | negate_f, -3);
+    BOOST_CHECK_EQUAL(qualified | get_f | negate_f, -3);
+    BOOST_CHECK_EQUAL(qualified | lvalue_f, 3);
+    BOOST_CHECK_EQUAL(Qualified{4} | rvalue_f, -4);
+    BOOST_CHECK((!pipeline::details::IsCallable<decltype(lvalue_f)&, Qualified>::value));
+    BOOST_CHECK((!pipeline::details::IsCallable<decltype(rvalue_f)&, Qualified&>::value));
+
+#ifdef __cpp_nontype_template_parameter_auto
+    m_func_call = 0;
+    mut_data | pipe_op<&func_const>();
+    BOOST_CHECK_EQUAL(m_func_call, 1);
+
+    Data::m_mut_call = 0;
+    mut_data | pipe_op_factory<&Data::mutWithArg>()(4) | pipe_op<&Data::mutWithoutArgs>();
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 2);
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 4);
+
+    BOOST_CHECK_EQUAL(qualified | pipe_op<&Qualified::get>() | pipe_op<&negate_noexcept>(), -3);
+#endif /* __cpp_nontype_template_parameter_auto */
+
+    BOOST_CHECK_EQUAL(Data::m_def_constructor, 2);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
+    BOOST_CHECK_EQUAL(Data::m_move_constructor, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_static_callable_is_empty) {
+    auto inc = pipe_op<decltype(&add_one), &add_one>();
+    auto dbl = pipe_op<decltype(&twice), &twice>();
+    auto chain = inc | dbl | inc;
+    auto lambda_chain = inc | pipe_op([](int n) { return n - 1; });
+
+    BOOST_CHECK(std::is_empty<decltype(inc.m_func)>::value);
+    BOOST_CHECK(std::is_empty<decltype(chain.m_func)>::value);
+    BOOST_CHECK(std::is_empty<decltype(lambda_chain.m_func)>::value);
+    BOOST_CHECK_EQUAL(chain(1), 5);
+    BOOST_CHECK_EQUAL(1 | lambda_chain, 1);
+
+    auto bound = pipe_op_factory<decltype(&mul3), &mul3>()(2, 3);
+    BOOST_CHECK_EQUAL(sizeof(bound), sizeof(std::tuple<int, int>));
+    BOOST_CHECK_EQUAL(1 | bound, 6);
+}
+
+int add_with_data(int n, Data) {
+    return n + 1;
+}
+
+/**
+   Функциональный объект копирование которого видно
+   по счётчикам Data
+*/
+struct DataFunctor {
+    Data m_data;
+
+    int operator()(int n, int add) const {
+        return n + add;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_rvalue_pipe_op_moves) {
+    Data::clear();
+
+    BOOST_CHECK_EQUAL(1 | add_with_data A(Data()), 2);
+    BOOST_CHECK_EQUAL(1 | DataFunctor() A(2), 3);
+    BOOST_CHECK_EQUAL(1 | pipe_op_factory(DataFunctor())(2), 3);
+    BOOST_CHECK_EQUAL(1 | (pipe_op(add_one) | add_with_data A(Data())), 3);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
+
+    // сохранённый PipeOp можно вызвать ещё раз, поэтому
+    // привязанный аргумент копируется
+    auto op = add_with_data A(Data());
+    BOOST_CHECK_EQUAL(1 | op, 2);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 1);
+
+    // последний вызов может забрать аргумент себе
+    BOOST_CHECK_EQUAL(1 | std::move(op), 2);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 1);
+
+    auto factory = pipe_op_factory(DataFunctor());
+    BOOST_CHECK_EQUAL(1 | factory(2), 3);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 2);
+    BOOST_CHECK_EQUAL(1 | std::move(factory)(2), 3);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 2);
+
+    // константный привязанный PipeOp
+    const auto const_op = pipe_op_factory(DataFunctor())(3);
+    BOOST_CHECK_EQUAL(2 | const_op, 5);
+    BOOST_CHECK_EQUAL(2 | const_op, 5);
+    const auto const_mul = pipe_op_factory(mul3)(2, 3);
+    BOOST_CHECK_EQUAL(2 | const_mul, 12);
+    BOOST_CHECK_EQUAL(2 | (pipe_op(add_one) | const_mul), 18);
+}
+
+BOOST_AUTO_TEST_CASE(test_any_pipe_op) {
+    std::vector<AnyPipeOp<int(int)>> stages;
+    stages.push_back(any_pipe_op<int(int)>(add_one));
+    stages.push_back(any_pipe_op<int(int)>(pipe_op(twice) | pipe_op(add_one)));
+    stages.push_back(any_pipe_op<int(int)>(mul3 A(2, 3)));
+
+    auto owned = std::make_unique<int>(10);
+    stages.push_back(any_pipe_op<int(int)>([owned = std::move(owned)](int n) {
+                return n + *owned;
+            }));
+
+    int value = 1;
+    for(const auto& stage : stages)
+        value = value | stage;
+    BOOST_CHECK_EQUAL(value, ((1 + 1) * 2 + 1) * 6 + 10);
+
+    AnyFunction<int(int)> moved(std::move(stages.back().m_func));
+    BOOST_CHECK(moved);
+    BOOST_CHECK(!stages.back().m_func);
+    BOOST_CHECK_EQUAL(moved(1), 11);
+    BOOST_CHECK_THROW(1 | stages.back(), std::bad_function_call);
+    BOOST_CHECK(!AnyFunction<int(int)>());
+    BOOST_CHECK_THROW(AnyFunction<int(int)>()(1), std::bad_function_call);
+
+    // большой объект не помещается в буфер и хранится в куче
+    std::array<int, 64> table{};
+    table[5] = 7;
+    auto lookup = [table](int n) { return table[n]; };
+    BOOST_CHECK(!AnyFunction<int(int)>::fitsInline<decltype(lookup)>());
+    BOOST_CHECK(AnyFunction<int(int)>::fitsInline<decltype(pipe_op(add_one))>());
+    BOOST_CHECK_EQUAL(5 | any_pipe_op<int(int)>(lookup), 7);
+    BOOST_CHECK_EQUAL((5 | any_pipe_op<int(int), sizeof(table)>(lookup)), 7);
+    BOOST_CHECK((AnyFunction<int(int), sizeof(table)>::fitsInline<decltype(lookup)>()));
+
+    Data::clear();
+    Data data;
+    auto mut = any_pipe_op<Data&(Data&)>(&Data::mutWithArg A(2) | &Data::mutWithArg A(3));
+    BOOST_CHECK_EQUAL(&(data | mut), &data);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 2);
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 3);
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
+}
+
+/**
+   Стадия с выравниванием больше чем у std::max_align_t
+*/
+struct alignas(64) AlignedAdd {
+    int m_add;
+
+    int operator()(int n) const {
+        return n + m_add;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_dynamic_pipeline) {
+    DynamicPipeline<int> rules;
+    BOOST_CHECK(rules.empty());
+    BOOST_CHECK_EQUAL(1 | rules, 1);
+
+    rules.append(add_one).append(pipe_op(twice) | pipe_op(add_one));
+    BOOST_CHECK_EQUAL(rules.size(), 2);
+    BOOST_CHECK_EQUAL(1 | rules, 5);
+
+    // добавление стадий переносит уже добавленные в новый буфер
+    auto owned = std::make_unique<int>(10);
+    rules.append([owned = std::move(owned)](int n) { return n + *owned; });
+    for(int i = 0; i < 20; ++i)
+        rules.append(mul3 A(1, 1));
+    rules.append(AlignedAdd{2});
+    BOOST_CHECK_EQUAL(rules.size(), 24);
+    BOOST_CHECK_EQUAL(1 | rules, 17);
+
+    const std::vector<int> expected{15, 17, 19};
+    BOOST_CHECK((numbers(3) | map(std::cref(rules)) | to_vector) == expected);
+
+    DynamicPipeline<int> moved(std::move(rules));
+    BOOST_CHECK_EQUAL(moved.size(), 24);
+    BOOST_CHECK_EQUAL(2 | moved, 19);
+
+    moved.clear();
+    BOOST_CHECK(moved.empty());
+    moved.append(twice);
+    BOOST_CHECK_EQUAL(2 | moved, 4);
+
+    // значение перемещается между стадиями, а не копируется
+    DynamicPipeline<std::vector<int>> moves;
+    moves.append([](std::vector<int> v) { v.push_back(1); return v; })
+        .append([](std::vector<int>&& v) { v.push_back(2); return std::move(v); });
+    std::vector<int> src;
+    src.reserve(4);
+    const int* buffer = src.data();
+    const std::vector<int> result = std::move(src) | moves;
+    BOOST_CHECK_EQUAL(result.data(), buffer);
+    BOOST_CHECK_EQUAL(result.size(), 2);
+}
+
+/**
+   Maybe со счётчиком проверок
+*/
+struct Checked {
+    static int m_checks;
+
+    bool m_ok;
+    int m_value;
+
+    Checked()
+        : m_ok(false),
+          m_value(0) {}
+
+    Checked(int value)
+        : m_ok(true),
+          m_value(value) {}
+};
+
+int Checked::m_checks;
+
+namespace pipeline {
+
+    template <>
+    struct MaybeTraits<Checked> {
+        static bool has(const Checked& checked) {
+            ++Checked::m_checks;
+            return checked.m_ok;
+        }
+
+        template <class TChecked>
+        static int get(TChecked&& checked) {
+            return checked.m_value;
+        }
+
+        template <class R>
+        using Rebind = Checked;
+
+        template <class R, class TChecked>
+        static R fail(TChecked&&) {
+            return R();
+        }
+    };
+
+} /* namespace pipeline */
+
+Checked checked(int n) {
+    return n < 0 ? Checked() : Checked(n);
+}
+
+BOOST_AUTO_TEST_CASE(test_maybe_custom) {
+    auto chain = pipe_op(checked) | pipe_op(add_one) | pipe_op(twice) | pipe_op(add_one);
+
+    Checked::m_checks = 0;
+    const Checked ok = 1 | chain;
+    BOOST_CHECK(ok.m_ok);
+    BOOST_CHECK_EQUAL(ok.m_value, 5);
+    BOOST_CHECK_EQUAL(Checked::m_checks, 1);
+
+    // пустое значение проверяется один раз на всю цепочку
+    Checked::m_checks = 0;
+    const Checked none = -1 | chain;
+    BOOST_CHECK(!none.m_ok);
+    BOOST_CHECK_EQUAL(Checked::m_checks, 1);
+
+    int calls = 0;
+    auto count = pipe_op([&calls](int) { ++calls; });
+    Checked() | count;
+    BOOST_CHECK_EQUAL(calls, 0);
+    Checked(3) | count;
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    // стадия которая принимает Maybe получает его как есть
+    BOOST_CHECK(!(Checked() | pipe_op([](const Checked& c) { return c.m_ok; })));
+}
+
+BOOST_AUTO_TEST_CASE(test_maybe_pointers) {
+    Data::clear();
+
+    Data data;
+    Data* ptr = &data;
+    Data* null = nullptr;
+
+    Data* result = ptr | &Data::mutWithArg A(2);
+    BOOST_CHECK_EQUAL(result, &data);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 1);
+
+    result = null | &Data::mutWithArg A(3) | &Data::mutWithArg A(4);
+    BOOST_CHECK(result == nullptr);
+    BOOST_CHECK_EQUAL(Data::m_mut_call, 1);
+
+    const auto owner = std::make_unique<Data>();
+    const Data* const_result = owner | &Data::constWithArg A(5);
+    BOOST_CHECK_EQUAL(const_result, owner.get());
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 5);
+
+    const std::shared_ptr<Data> empty;
+    BOOST_CHECK(!(empty | &Data::constWithArg A(6)));
+    BOOST_CHECK_EQUAL(Data::m_arg_value, 5);
+
+    BOOST_CHECK_EQUAL(Data::m_copy_constructor, 0);
+    BOOST_CHECK_EQUAL(Data::m_move_constructor, 0);
+
+    // строка не Maybe: её не разыменовывают ради стадии от char
+    using pipeline::details::IsCallable;
+    using pipeline::details::IsMaybe;
+    auto first = pipe_op([](char c) { return c; });
+    BOOST_CHECK((IsMaybe<const int*>::value));
+    BOOST_CHECK((!IsMaybe<const char*>::value));
+    BOOST_CHECK((!IsMaybe<wchar_t*>::value));
+    BOOST_CHECK((!IsCallable<decltype(first)&, const char*>::value));
+}
+
+#ifdef __cpp_lib_optional
+std::optional<int> positive(int n) {
+    if(n > 0)
+        return n;
+    return std::nullopt;
+}
+
+BOOST_AUTO_TEST_CASE(test_maybe_optional) {
+    auto chain = pipe_op(positive) | pipe_op(twice) | pipe_op(positive) | pipe_op(add_one);
+    BOOST_CHECK((std::is_same<decltype(1 | chain), std::optional<int>>::value));
+    BOOST_CHECK_EQUAL(*(2 | chain), 5);
+    BOOST_CHECK(!(-2 | chain));
+
+    const std::optional<int> value(3);
+    BOOST_CHECK_EQUAL(*(value | pipe_op(add_one)), 4);
+    BOOST_CHECK(!(std::optional<int>() | pipe_op(add_one)));
+
+    Record record{7};
+    const Record* ptr = &record;
+    const Record* null = nullptr;
+    BOOST_CHECK_EQUAL(*(ptr | pipe_op(&Record::id)), 7);
+    BOOST_CHECK(!(null | pipe_op(&Record::id)));
+}
+#endif /* __cpp_lib_optional */
+
+Expected<int, std::error_code> checked_div(int n) {
+    if(n == 0)
+        return make_unexpected(std::make_error_code(std::errc::invalid_argument));
+    return 100 / n;
+}
+
+Expected<std::string, std::error_code> non_empty(std::string line) {
+    if(line.empty())
+        return make_unexpected(std::make_error_code(std::errc::no_message));
+    return line;
+}
+
+std::size_t length(const std::string& line) {
+    return line.size();
+}
+
+BOOST_AUTO_TEST_CASE(test_expected) {
+    int calls = 0;
+    auto count = pipe_op([&calls](int n) { ++calls; return n; });
+    auto chain = pipe_op(checked_div) | count | pipe_op(twice) | pipe_op(checked_div) | count;
+
+    const auto ok = 5 | chain;
+    BOOST_CHECK((std::is_same<std::decay_t<decltype(ok)>, Expected<int, std::error_code>>::value));
+    BOOST_REQUIRE(ok);
+    BOOST_CHECK_EQUAL(*ok, 2);
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    // ошибка пропускает все оставшиеся стадии и доходит до конца
+    calls = 0;
+    const auto failed = 0 | chain;
+    BOOST_REQUIRE(!failed);
+    BOOST_CHECK(failed.error() == std::errc::invalid_argument);
+    BOOST_CHECK_EQUAL(calls, 0);
+
+    // ошибка во второй стадии checked_div
+    calls = 0;
+    const auto late = 200 | chain;
+    BOOST_REQUIRE(!late);
+    BOOST_CHECK(late.error() == std::errc::invalid_argument);
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    // результат обычной стадии заворачивается в Expected с той же ошибкой
+    const auto size = std::string() | pipe_op(non_empty) | pipe_op(length);
+    BOOST_CHECK((std::is_same<std::decay_t<decltype(size)>, Expected<std::size_t, std::error_code>>::value));
+    BOOST_CHECK(size.error() == std::errc::no_message);
+
+    const Expected<std::string, std::error_code> line("abc");
+    BOOST_CHECK_EQUAL(*(line | pipe_op(length)), 3);
+    BOOST_CHECK_EQUAL(*line, "abc");
+}
+
+const StageStats& find_stats(const std::vector<StageStats>& stats, const std::string& label) {
+    return *std::find_if(stats.begin(), stats.end(), [&label](const StageStats& s) {
+            return s.m_label == label;
+        });
+}
+
+BOOST_AUTO_TEST_CASE(test_instrument) {
+    auto op = pipe_op(add_one);
+#ifndef PIPELINE_INSTRUMENTATION
+    // без макроса instrument ничего не меняет
+    BOOST_CHECK((std::is_same<decltype(instrument("add_one", op)), decltype(op)>::value));
+#endif /* PIPELINE_INSTRUMENTATION */
+
+    using pipeline::details::instrumented;
+
+    reset_stage_stats();
+    auto chain = instrumented("test.add_one", op) | instrumented("test.numbers", pipe_op(numbers))
+        | instrumented("test.print", pipe_op([](const std::vector<int>&) {}));
+    1 | chain;
+    2 | chain;
+
+    std::thread([&chain] { 3 | chain; }).join();
+
+    const auto stats = stage_stats();
+    const StageStats& add = find_stats(stats, "test.add_one");
+    BOOST_CHECK_EQUAL(add.m_calls, 3);
+    BOOST_CHECK_EQUAL(add.m_input_size, 3);
+    BOOST_CHECK_EQUAL(add.m_output_size, 3);
+
+    const StageStats& gen = find_stats(stats, "test.numbers");
+    BOOST_CHECK_EQUAL(gen.m_calls, 3);
+    BOOST_CHECK_EQUAL(gen.m_output_size, 2 + 3 + 4);
+
+    const StageStats& print = find_stats(stats, "test.print");
+    BOOST_CHECK_EQUAL(print.m_calls, 3);
+    BOOST_CHECK_EQUAL(print.m_input_size, 2 + 3 + 4);
+    BOOST_CHECK_EQUAL(print.m_output_size, 0);
+    BOOST_CHECK(print.m_nanoseconds <= add.m_nanoseconds + gen.m_nanoseconds + print.m_nanoseconds);
+
+    reset_stage_stats();
+    BOOST_CHECK_EQUAL(find_stats(stage_stats(), "test.add_one").m_calls, 0);
+}
+
+std::size_t count_of(const std::string& text, const std::string& pattern) {
+    std::size_t count = 0;
+    for(auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+BOOST_AUTO_TEST_CASE(test_trace) {
+    using pipeline::details::instrumented;
+
+    const std::string path = "test_trace.json";
+    auto chain = instrumented("trace.add_one", pipe_op(add_one)) | instrumented("trace.numbers", pipe_op(numbers));
+
+    // до start_trace события не пишутся
+    1 | chain;
+    BOOST_CHECK(flush_trace(path));
+    BOOST_CHECK_EQUAL(count_of(read_file(path), "\"trace."), 0);
+
+    start_trace();
+    1 | chain;
+    2 | chain;
+    std::thread([&chain] { 3 | chain; }).join();
+    stop_trace();
+    4 | chain;
+
+    BOOST_CHECK(flush_trace(path));
+    const std::string trace = read_file(path);
+    BOOST_CHECK_EQUAL(trace.find("{\"traceEvents\":["), 0);
+    BOOST_CHECK_EQUAL(count_of(trace, "{\"name\":\"trace.add_one\",\"ph\":\"B\""), 3);
+    BOOST_CHECK_EQUAL(count_of(trace, "{\"name\":\"trace.add_one\",\"ph\":\"E\""), 3);
+    BOOST_CHECK_EQUAL(count_of(trace, "{\"name\":\"trace.numbers\",\"ph\":\"E\""), 3);
+    BOOST_CHECK_EQUAL(count_of(trace, "\"args\":{\"size\":4}"), 1);
+    BOOST_CHECK_EQUAL(count_of(trace, "\"tid\":"), 12);
+
+    // события уже сохранены
+    BOOST_CHECK(flush_trace(path));
+    BOOST_CHECK_EQUAL(count_of(read_file(path), "\"ph\":"), 0);
+
+    std::remove(path.c_str());
+    BOOST_CHECK(!flush_trace("no_such_dir/trace.json"));
+}
+
+int square_calls = 0;
+
+int square(int n) {
+    ++square_calls;
+    return n * n;
+}
+
+BOOST_AUTO_TEST_CASE(test_cache) {
+    square_calls = 0;
+    auto op = cache<int>(square, 3);
+
+    BOOST_CHECK_EQUAL(2 | op, 4);
+    BOOST_CHECK_EQUAL(2 | op, 4);
+    BOOST_CHECK_EQUAL(3 | op, 9);
+    BOOST_CHECK_EQUAL(square_calls, 2);
+
+    // копии стадии и композиции разделяют таблицу
+    auto chain = op | pipe_op(add_one);
+    BOOST_CHECK_EQUAL(3 | chain, 10);
+    BOOST_CHECK_EQUAL(square_calls, 2);
+
+    CacheStats stats = cache_stats(op);
+    BOOST_CHECK_EQUAL(stats.m_hits, 2);
+    BOOST_CHECK_EQUAL(stats.m_misses, 2);
+    BOOST_CHECK_EQUAL(stats.m_size, 2);
+
+    // 2 и 3 отмечены обращением, поэтому CLOCK
+    // вытесняет 4, а не их
+    4 | op;
+    2 | op;
+    3 | op;
+    5 | op;
+    BOOST_CHECK_EQUAL(square_calls, 4);
+    2 | op;
+    3 | op;
+    BOOST_CHECK_EQUAL(square_calls, 4);
+    4 | op;
+    BOOST_CHECK_EQUAL(square_calls, 5);
+
+    stats = cache_stats(op);
+    BOOST_CHECK_EQUAL(stats.m_evictions, 2);
+    BOOST_CHECK_EQUAL(stats.m_size, 3);
+
+    // много вытеснений: таблица не теряет записи при сдвигах
+    auto small = cache<int>([](int n) { return n + 1; }, 16);
+    for(int i = 0; i < 10000; ++i)
+        BOOST_CHECK_EQUAL(i % 37 | small, i % 37 + 1);
+    BOOST_CHECK_EQUAL(cache_stats(small).m_size, 16);
+
+    auto lengths = cache<std::string>(length, 4);
+    BOOST_CHECK_EQUAL(std::string("abc") | lengths, 3);
+}
+
+/**
+   Ключ, копирование которого бросает исключение
+   когда m_throw равен true
+*/
+struct ThrowingKey {
+    static bool m_throw;
+    int m_value;
+
+    explicit ThrowingKey(int value)
+        : m_value(value) {}
+
+    ThrowingKey(const ThrowingKey& other)
+        : m_value(other.m_value) {
+        if(m_throw)
+            throw std::runtime_error("key copy");
+    }
+
+    ThrowingKey& operator=(const ThrowingKey&) = default;
+
+    bool operator==(const ThrowingKey& other) const {
+        return m_value == other.m_value;
+    }
+};
+
+bool ThrowingKey::m_throw = false;
+
+struct ThrowingKeyHash {
+    std::size_t operator()(const ThrowingKey& key) const {
+        return std::hash<int>()(key.m_value);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_cache_throwing_key) {
+    auto op = cache<ThrowingKey>([](const ThrowingKey& key) { return key.m_value * 2; }, 2, ThrowingKeyHash());
+    BOOST_CHECK_EQUAL(ThrowingKey(1) | op, 2);
+    BOOST_CHECK_EQUAL(ThrowingKey(2) | op, 4);
+
+    // копирование ключа при вытеснении бросает: таблица остаётся целой
+    ThrowingKey::m_throw = true;
+    BOOST_CHECK_THROW(ThrowingKey(3) | op, std::runtime_error);
+    ThrowingKey::m_throw = false;
+
+    BOOST_CHECK_EQUAL(ThrowingKey(3) | op, 6);
+    BOOST_CHECK_EQUAL(ThrowingKey(4) | op, 8);
+    BOOST_CHECK_EQUAL(cache_stats(op).m_size, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_sharded_cache) {
+    std::atomic<int> calls(0);
+    auto op = sharded_cache<int>([&calls](int n) {
+            ++calls;
+            return n * 2;
+        }, 1024, 4);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t)
+        threads.emplace_back([&op] {
+                for(int i = 0; i < 1000; ++i)
+                    BOOST_REQUIRE_EQUAL(i % 100 | op, i % 100 * 2);
+            });
+    for(auto& thread : threads)
+        thread.join();
+
+    const CacheStats stats = cache_stats(op);
+    BOOST_CHECK_EQUAL(stats.m_hits + stats.m_misses, 4000);
+    BOOST_CHECK_EQUAL(stats.m_size, 100);
+    // без блокировки на время вызова одно значение
+    // может посчитаться в нескольких потоках
+    BOOST_CHECK(calls >= 100 && calls <= 400);
+}
+
+ArenaVector<int> arena_numbers(int n) {
+    ArenaVector<int> result;
+    for(int i = 0; i < n; ++i)
+        result.push_back(i);
+    return result;
+}
+
+int arena_sum(const ArenaVector<int>& numbers) {
+    return std::accumulate(numbers.begin(), numbers.end(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_arena) {
+    auto chain = pipe_op(arena_numbers) | pipe_op(arena_sum);
+
+    // без арены контейнеры работают через operator new
+    BOOST_CHECK(current_arena() == nullptr);
+    BOOST_CHECK_EQUAL(10 | chain, 45);
+
+    Arena arena(1024);
+    {
+        ArenaScope scope(arena);
+        BOOST_CHECK(current_arena() == &arena);
+        BOOST_CHECK(ArenaVector<int>().get_allocator().arena() == &arena);
+
+        BOOST_CHECK_EQUAL(10 | chain, 45);
+        const std::size_t run = arena.bytes();
+        BOOST_CHECK(run >= 10 * sizeof(int));
+
+        {
+            ArenaScope batch(arena);
+            BOOST_CHECK_EQUAL(1000 | chain, 999 * 1000 / 2);
+            BOOST_CHECK(arena.bytes() > run);
+        }
+        // вложенная область откатывает только своё
+        BOOST_CHECK_EQUAL(arena.bytes(), run);
+    }
+    BOOST_CHECK(current_arena() == nullptr);
+    BOOST_CHECK_EQUAL(arena.bytes(), 0);
+
+    // блоки остаются у арены для следующих прогонов
+    const std::size_t capacity = arena.capacity();
+    for(int i = 0; i < 10; ++i) {
+        ArenaScope scope(arena);
+        1000 | chain;
+    }
+    BOOST_CHECK_EQUAL(arena.capacity(), capacity);
+
+    ArenaString text{ArenaAllocator<char>(&arena)};
+    text.assign(100, 'x');
+    void* aligned = arena.allocate(1, 64);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0);
+
+    Arena huge(Arena::default_block_size, true);
+    ArenaScope scope(huge);
+    BOOST_CHECK_EQUAL(100 | chain, 4950);
+}
+
+#ifdef __cpp_lib_string_view
+void write_file(const std::string& path, const std::string& content) {
+    std::ofstream(path, std::ios::binary) << content;
+}
+
+BOOST_AUTO_TEST_CASE(test_mapped_file) {
+    write_file("test_mapped_1.txt", "alpha\nbeta\n\ngamma");
+    write_file("test_mapped_2.txt", "delta\n");
+    write_file("test_mapped_empty.txt", "");
+
+    auto file = map_file("test_mapped_1.txt");
+    BOOST_REQUIRE(file);
+    BOOST_CHECK_EQUAL(file->size(), 17);
+
+    auto lines = *file | records('\n') | to_vector;
+    BOOST_REQUIRE_EQUAL(lines.size(), 4);
+    BOOST_CHECK_EQUAL(lines[0], "alpha");
+    BOOST_CHECK(lines[2].empty());
+    BOOST_CHECK_EQUAL(lines[3], "gamma");
+    // записи указывают в отображение, а не в копию
+    BOOST_CHECK(lines[0].data() == file->data());
+
+    auto long_lines = *file | records() | filter([](std::string_view line) { return line.size() > 4; })
+        | map([](std::string_view line) { return std::string(line); }) | to_vector;
+    BOOST_CHECK((long_lines == std::vector<std::string>{"alpha", "gamma"}));
+
+    auto pairs = *file | fixed_records(2) | to_vector;
+    BOOST_CHECK_EQUAL(pairs.size(), 8);
+    BOOST_CHECK_EQUAL(pairs[1], "ph");
+
+    auto files = map_files({"test_mapped_1.txt", "test_mapped_2.txt", "test_mapped_empty.txt"});
+    BOOST_REQUIRE(files);
+    BOOST_CHECK_EQUAL((*files | records() | to_vector).size(), 5);
+    BOOST_CHECK((*files)[2].empty());
+
+    const std::string text = "a,b,c";
+    BOOST_CHECK((text | records(',') | take(2) | to_vector) == std::vector<std::string_view>({"a", "b"}));
+    BOOST_CHECK_EQUAL((std::string_view("a,b,c") | records(',') | to_vector).size(), 3);
+
+    // записи временного владеющего буфера повисли бы
+    BOOST_CHECK((std::is_invocable<decltype(records()), std::string&>::value));
+    BOOST_CHECK((!std::is_invocable<decltype(records()), std::string>::value));
+    BOOST_CHECK((!std::is_invocable<decltype(records()), MappedFile>::value));
+    BOOST_CHECK((!std::is_invocable<decltype(split()), std::vector<std::string>>::value));
+    BOOST_CHECK((std::is_invocable<decltype(split()), std::vector<std::string_view>>::value));
+
+    auto missing = map_file("test_mapped_missing.txt");
+    BOOST_REQUIRE(!missing);
+    BOOST_CHECK(missing.error() == std::errc::no_such_file_or_directory);
+    BOOST_CHECK(!map_files({"test_mapped_1.txt", "test_mapped_missing.txt"}));
+
+    std::remove("test_mapped_1.txt");
+    std::remove("test_mapped_2.txt");
+    std::remove("test_mapped_empty.txt");
+}
+
+std::vector<std::string_view> naive_split(std::string_view text, char delim) {
+    std::vector<std::string_view> result;
+    std::size_t begin = 0;
+    while(begin < text.size()) {
+        const std::size_t end = std::min(text.find(delim, begin), text.size());
+        result.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(test_delimiter_scan) {
+    using pipeline::details::SimdLevel;
+    using pipeline::details::best_simd_level;
+    using pipeline::details::delimiter_kernel;
+    using pipeline::details::scan_records;
+
+    // разная плотность разделителей, разделители на границах
+    // векторов и блоков, длина не кратна 32
+    std::string text;
+    for(int i = 0; i < 20000; ++i)
+        text.push_back(i % 7 == 0 || i % 4096 == 4095 || i % 32 == 31 ? '\n' : 'a' + i % 26);
+    text += "tail";
+
+    const auto expected = naive_split(text, '\n');
+    for(SimdLevel level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2}) {
+        if(level > best_simd_level())
+            continue;
+
+        std::vector<std::string_view> found;
+        scan_records(text.data(), text.size(), '\n', [&found](const char* begin, const char* end) {
+                found.emplace_back(begin, end - begin);
+                return true;
+            }, delimiter_kernel(level));
+        BOOST_CHECK(found == expected);
+    }
+
+    BOOST_CHECK((text | records() | to_vector) == expected);
+
+    std::vector<std::size_t> sizes;
+    auto lines = text | split('\n', 1000) | map([&sizes](Span<const std::string_view> batch) {
+            sizes.push_back(batch.size());
+            return std::vector<std::string_view>(batch.begin(), batch.end());
+        }) | unbatch | to_vector;
+    BOOST_CHECK(lines == expected);
+    BOOST_CHECK_EQUAL(sizes.size(), (expected.size() + 999) / 1000);
+    BOOST_CHECK_EQUAL(sizes.front(), 1000);
+
+    const std::string short_text = "a\nb\n";
+    BOOST_CHECK((short_text | split() | unbatch | to_vector) == std::vector<std::string_view>({"a", "b"}));
+    BOOST_CHECK((std::string_view() | split() | unbatch | to_vector).empty());
+
+    // пакеты ссылаются на общий буфер, собирать их нельзя
+    using Split = decltype(short_text | split());
+    BOOST_CHECK((!std::is_invocable<decltype(to_vector), Split>::value));
+}
+#endif /* __cpp_lib_string_view */
+
+BOOST_AUTO_TEST_CASE(test_file_sink) {
+    const std::string path = "test_file_sink.txt";
+
+    FileSinkOptions options;
+    // маленькие буферы, чтобы стадия отдавала их и ждала
+    options.m_buffer_size = 16;
+    options.m_buffers = 2;
+    options.m_separator = "\n";
+    {
+        auto sink = file_sink(path, options);
+        BOOST_REQUIRE(sink);
+
+        std::string("alpha") | *sink;
+        "beta" | *sink;
+        std::vector<std::string>{"gamma", "", "a record longer than one buffer"} | *sink;
+        std::vector<int>{1, 2, 3} | map([](int i) { return std::to_string(i); }) | *sink;
+        BOOST_CHECK(!flush_sink(*sink));
+
+        const FileSinkStats stats = sink_stats(*sink);
+        BOOST_CHECK_EQUAL(stats.m_records, 8);
+        BOOST_CHECK_EQUAL(stats.m_bytes, 56);
+        BOOST_CHECK_GT(stats.m_buffers, 2);
+        BOOST_CHECK_GE(stats.m_writes, 1);
+        BOOST_CHECK_LE(stats.m_writes, stats.m_buffers);
+    }
+    BOOST_CHECK_EQUAL(read_file(path), "alpha\nbeta\ngamma\n\na record longer than one buffer\n1\n2\n3\n");
+
+    // дописывание, остаток пишет деструктор
+    options.m_append = true;
+    options.m_separator.clear();
+    {
+        auto sink = file_sink(path, options);
+        BOOST_REQUIRE(sink);
+        "end" | *sink;
+    }
+    BOOST_CHECK_EQUAL(read_file(path).substr(54), "3\nend");
+
+    auto missing = file_sink("test_file_sink_missing/out.txt");
+    BOOST_REQUIRE(!missing);
+    BOOST_CHECK(missing.error() == std::errc::no_such_file_or_directory);
+
+    std::remove(path.c_str());
+}
+
+template <class T>
+void check_simd(SimdLevel level) {
+    std::vector<T> values(1003);
+    for(std::size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<T>(static_cast<int>(i * 37 % 201) - 100);
+
+    auto scale = [](auto x) { return min(max(x * 3 - 20, -100), 250); };
+    auto keep = [](auto x) { return (x > -50) & (x != 0); };
+
+    std::vector<T> mapped;
+    std::vector<T> kept;
+    for(T value : values) {
+        mapped.push_back(std::min<T>(std::max<T>(value * 3 - 20, -100), 250));
+        if(value > -50 && value != 0)
+            kept.push_back(value);
+    }
+
+    BOOST_CHECK((values | simd_map(scale, level)) == mapped);
+    BOOST_CHECK((values | simd_filter(keep, level)) == kept);
+
+    // остаток короче одного Pack
+    std::vector<T> tail(values.begin(), values.begin() + 3);
+    BOOST_CHECK(((Span<const T>(tail.data(), tail.size()) | simd_map(scale, level))
+                 == std::vector<T>(mapped.begin(), mapped.begin() + 3)));
+    BOOST_CHECK((std::vector<T>() | simd_filter(keep, level)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_simd) {
+    for(SimdLevel level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2, SimdLevel::avx512}) {
+        if(level > best_simd_level())
+            continue;
+
+        check_simd<float>(level);
+        check_simd<double>(level);
+        check_simd<std::int32_t>(level);
+        check_simd<std::int64_t>(level);
+
+        // тип результата может отличаться от типа элементов
+        const std::vector<std::int32_t> ints{1, 4, 9, 16, 25};
+        auto roots = ints | simd_map([](auto x) { return sqrt(pack_cast<float>(x)); }, level);
+        BOOST_CHECK((roots == std::vector<float>{1, 2, 3, 4, 5}));
+
+        auto magnitudes = std::vector<float>{-1.5f, 2, -3} | simd_map([](auto x) { return abs(x); }, level);
+        BOOST_CHECK((magnitudes == std::vector<float>{1.5f, 2, 3}));
+    }
+}
+
+#ifdef __cpp_lib_coroutine
+BOOST_AUTO_TEST_CASE(test_async) {
+    EventLoop loop;
+    const auto loop_thread = std::this_thread::get_id();
+
+    // обычные функции и цепочка стадий
+    BOOST_CHECK_EQUAL(loop.run(5 | async(add_one, loop)), 6);
+    BOOST_CHECK_EQUAL(loop.run(5 | async(add_one, loop) | async(add_one, loop)), 7);
+    BOOST_CHECK_EQUAL(loop.run(5 | (async(add_one, loop) | async(pipe_op(add_one) | pipe_op(add_one), loop))), 8);
+
+    // стадия возвращающая awaitable: работа в пуле, продолжение в loop
+    std::vector<std::thread::id> threads;
+    auto doubled = async([&loop](int x) { return loop.offload([x] { return x * 2; }); }, loop);
+    auto record = async([&threads](int x) {
+            threads.push_back(std::this_thread::get_id());
+            return x;
+        }, loop);
+    BOOST_CHECK_EQUAL(loop.run(21 | doubled | record), 42);
+
+    // стадия-сопрограмма
+    auto parse = async([&loop](std::string text) -> Task<int> {
+            auto to_int = [text] { return std::stoi(text); };
+            const int value = co_await loop.offload(to_int);
+            co_return value + 1;
+        }, loop);
+
+    // много конвейеров в одном потоке
+    std::vector<int> results;
+    auto collect = async([&results](int x) { results.push_back(x); }, loop);
+    for(int i = 0; i < 100; ++i)
+        loop.spawn(std::to_string(i) | parse | doubled | record | collect);
+    loop.run();
+
+    std::sort(results.begin(), results.end());
+    BOOST_REQUIRE_EQUAL(results.size(), 100);
+    BOOST_CHECK_EQUAL(results.front(), 2);
+    BOOST_CHECK_EQUAL(results.back(), 200);
+    BOOST_CHECK_EQUAL(threads.size(), 101);
+    BOOST_CHECK(std::all_of(threads.begin(), threads.end(), [loop_thread](std::thread::id id) { return id == loop_thread; }));
+
+    // Maybe значения и исключения
+    BOOST_CHECK(!loop.run(std::optional<int>() | async(add_one, loop)));
+    auto fail = async([&loop](int x) { return loop.offload([x]() -> int { throw std::runtime_error("offload"); }); }, loop);
+    BOOST_CHECK_THROW(loop.run(1 | fail | async(add_one, loop)), std::runtime_error);
+    loop.spawn(1 | fail);
+    loop.spawn(2 | async(add_one, loop));
+    BOOST_CHECK_THROW(loop.run(), std::runtime_error);
+
+    // кадры spawn без run уничтожаются вместе с loop
+    auto owner = std::make_shared<int>(1);
+    {
+        EventLoop idle;
+        idle.spawn([](std::shared_ptr<int> held) -> Task<int> { co_return *held; }(owner));
+        BOOST_CHECK_EQUAL(owner.use_count(), 2);
+    }
+    BOOST_CHECK_EQUAL(owner.use_count(), 1);
+}
+
+Generator<int> naturals(int& yielded) {
+    for(int i = 0;; ++i) {
+        ++yielded;
+        co_yield i;
+    }
+}
+
+Generator<std::string> words(int count) {
+    for(int i = 0; i < count; ++i) {
+        if(i == 3)
+            throw std::runtime_error("generator");
+        co_yield std::to_string(i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_generator) {
+    // бесконечный генератор останавливается стадией take
+    int yielded = 0;
+    auto odd = naturals(yielded) | filter([](int x) { return x % 2 == 1; }) | map([](int x) { return x * 10; }) | take(3) | to_vector;
+    BOOST_CHECK((odd == std::vector<int>{10, 30, 50}));
+    BOOST_CHECK_EQUAL(yielded, 6);
+
+    // генератор-lvalue и пачки
+    yielded = 0;
+    auto gen = naturals(yielded);
+    auto sums = gen | take(10) | batch(4) | map([](Span<int> span) { return std::accumulate(span.begin(), span.end(), 0); }) | to_vector;
+    BOOST_CHECK((sums == std::vector<int>{6, 22, 17}));
+    BOOST_CHECK_EQUAL(yielded, 10);
+
+    // строки и исключение из сопрограммы
+    auto text = words(3) | map([](std::string& word) { return word + "!"; }) | to_vector;
+    BOOST_CHECK((text == std::vector<std::string>{"0!", "1!", "2!"}));
+    BOOST_CHECK_THROW(words(5) | to_vector, std::runtime_error);
+    BOOST_CHECK_EQUAL((words(5) | take(2) | to_vector).size(), 2);
+}
+#endif /* __cpp_lib_coroutine */